@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include "alias.h"
+#include "counters.h"
+
+#define ALIAS_EMPTY 0xff
+
+static uint32_t alias_hash(const struct AliasTracker *a, uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - a->log_cap));
+}
+
+// Sætter en tom skygge med 2^log_cap pladser ind. Ved fejl er a uændret.
+static int alias_alloc_map(struct AliasTracker *a, int log_cap) {
+    size_t cap = (size_t)1 << log_cap;
+    uint64_t *keys = malloc(cap * sizeof *keys);
+    uint8_t *ctrs = malloc(cap);
+    if (!keys || !ctrs) {
+        free(keys);
+        free(ctrs);
+        return -1;
+    }
+    for (size_t i = 0; i < cap; i++)
+        ctrs[i] = ALIAS_EMPTY;
+    a->keys = keys;
+    a->ctrs = ctrs;
+    a->log_cap = log_cap;
+    a->used = 0;
+    return 0;
+}
+
+int alias_init(struct AliasTracker *a, int entries) {
+    if (entries <= 0 || (entries & (entries - 1)))
+        return -1;
+    a->entries = entries;
+    a->keys = NULL;
+    a->ctrs = NULL;
+    a->last_key = malloc(entries * sizeof *a->last_key);
+    a->distinct = calloc(entries, sizeof *a->distinct);
+    if (!a->last_key || !a->distinct || alias_alloc_map(a, 12) != 0) {
+        alias_free(a);
+        return -1;
+    }
+    return 0;
+}
+
+void alias_free(struct AliasTracker *a) {
+    free(a->last_key);
+    free(a->distinct);
+    free(a->keys);
+    free(a->ctrs);
+    a->last_key = NULL;
+    a->distinct = NULL;
+    a->keys = NULL;
+    a->ctrs = NULL;
+}
+
+// Finder pladsen for key; ny nøgle indsættes med counter = 1 (svagt ikke taget,
+// som tabellerne i simulate.c). *is_new sættes hvis nøglen ikke var set før.
+// Returnerer NULL hvis skyggen skulle vokse og der ikke var hukommelse.
+static uint8_t *alias_lookup(struct AliasTracker *a, uint64_t key, int *is_new) {
+    uint32_t mask = (1u << a->log_cap) - 1;
+    uint32_t h = alias_hash(a, key);
+    while (a->ctrs[h] != ALIAS_EMPTY && a->keys[h] != key)
+        h = (h + 1) & mask;
+    *is_new = a->ctrs[h] == ALIAS_EMPTY;
+    if (!*is_new)
+        return &a->ctrs[h];
+
+    // hold belastningen under 1/2
+    if (2 * (a->used + 1) > (1 << a->log_cap)) {
+        uint64_t *old_keys = a->keys;
+        uint8_t *old_ctrs = a->ctrs;
+        int old_cap = 1 << a->log_cap;
+        if (alias_alloc_map(a, a->log_cap + 1) != 0)
+            return NULL;
+        mask = (1u << a->log_cap) - 1;
+        for (int i = 0; i < old_cap; i++) {
+            if (old_ctrs[i] == ALIAS_EMPTY)
+                continue;
+            uint32_t j = alias_hash(a, old_keys[i]);
+            while (a->ctrs[j] != ALIAS_EMPTY)
+                j = (j + 1) & mask;
+            a->keys[j] = old_keys[i];
+            a->ctrs[j] = old_ctrs[i];
+            a->used++;
+        }
+        free(old_keys);
+        free(old_ctrs);
+        h = alias_hash(a, key);
+        while (a->ctrs[h] != ALIAS_EMPTY)
+            h = (h + 1) & mask;
+    }
+    a->keys[h] = key;
+    a->ctrs[h] = 1;
+    a->used++;
+    return &a->ctrs[h];
+}
+
+int alias_access(struct AliasTracker *a, struct AliasStat *st, uint32_t idx, uint64_t key,
+                 int taken, int real_correct) {
+    idx &= a->entries - 1;
+    int is_new;
+    uint8_t *c = alias_lookup(a, key, &is_new);
+    if (!c)
+        return -1;
+    int shadow_correct = ctr2_predict(*c) == taken;
+    *c = ctr2_sat(*c, taken);
+
+    if (is_new) {
+        st->keys++;
+        if (a->distinct[idx] < UINT16_MAX)
+            a->distinct[idx]++;
+    }
+    st->accesses++;
+    // entry blev sidst brugt af en anden nøgle
+    if (a->distinct[idx] > 1 && a->last_key[idx] != key)
+        st->aliased++;
+    a->last_key[idx] = key;
+
+    if (!real_correct && shadow_correct)
+        st->destructive++;
+    else if (real_correct && !shadow_correct)
+        st->constructive++;
+    else if (!real_correct)
+        st->unpredictable++;
+    return 0;
+}
+
+void alias_finish(const struct AliasTracker *a, struct AliasStat *st) {
+    st->entries_used = 0;
+    st->entries_shared = 0;
+    st->max_sharing = 0;
+    for (int i = 0; i < a->entries; i++) {
+        int d = a->distinct[i];
+        if (d >= 1)
+            st->entries_used++;
+        if (d >= 2)
+            st->entries_shared++;
+        if (d > st->max_sharing)
+            st->max_sharing = d;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef __ALIAS_H__
+#define __ALIAS_H__
+
+#include <stdint.h>
+
+// Aliasing analyse for en PC-indekseret tabel af 2-bit counters (bimodal/gShare).
+// Hver adgang har en nøgle (pc eller pc/historie par) og en entry. Ved siden af
+// tabellen køres en interferensfri skygge med én counter per nøgle, så en
+// misprediction kan klassificeres som aliasing eller reel uforudsigelighed.
+
+// Aliasing i bimodal/gShare tabeller, kun udfyldt med -aliasing. En nøgle er pc
+// for bimodal og pc/historie par for gShare. Mispredictions deles efter hvad en
+// interferensfri predictor (én counter per nøgle) ville have gjort:
+// destructive = kun tabellen fejler, unpredictable = begge fejler.
+// constructive = tabellen rammer, men den interferensfri fejler.
+struct AliasStat {
+    unsigned long long accesses;
+    unsigned long long aliased;     // adgange hvor entry sidst blev brugt af en anden nøgle
+    unsigned long long destructive;
+    unsigned long long constructive;
+    unsigned long long unpredictable;
+    unsigned long long keys;        // forskellige nøgler
+    int entries_used;
+    int entries_shared;             // entries med mindst to nøgler
+    int max_sharing;                // flest nøgler i én entry
+};
+
+struct AliasTracker {
+    int entries;
+    uint64_t *last_key;     // seneste nøgle per entry
+    uint16_t *distinct;     // antal forskellige nøgler set per entry (mætter)
+
+    // skygge: open addressing hash fra nøgle til 2-bit counter
+    int log_cap;
+    int used;
+    uint64_t *keys;
+    uint8_t *ctrs;          // 0xff = tom plads
+};
+
+// returnerer 0 ved succes, -1 ved ugyldig størrelse eller manglende hukommelse
+int alias_init(struct AliasTracker *a, int entries);
+void alias_free(struct AliasTracker *a);
+// Registrerer én adgang til entry idx med nøgle key. real_correct er om den
+// rigtige tabel forudsagde korrekt. Returnerer -1 hvis skyggen ikke kunne
+// vokse; a er så uændret.
+int alias_access(struct AliasTracker *a, struct AliasStat *st, uint32_t idx, uint64_t key,
+                 int taken, int real_correct);
+// Udfylder entry tællerne i st
+void alias_finish(const struct AliasTracker *a, struct AliasStat *st);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef __BINIO_H__
+#define __BINIO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Fælles hjælpere til de binære formater (trace, memtrace, commit log og lz):
+// zigzag, varints, little-endian u32 og bufferet læsning af bytes.
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// 7 bits per byte, mindst betydende først. Højst 5 bytes.
+static inline uint8_t *put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// Returnerer pladsen efter de 4 bytes
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Læser en FILE gennem en buffer som ejeren stiller til rådighed
+struct ByteReader {
+    FILE *in;
+    uint8_t *buf;
+    size_t size;
+    size_t pos;
+    size_t len;
+};
+
+static inline void byte_reader_init(struct ByteReader *br, FILE *in, uint8_t *buf, size_t size) {
+    br->in = in;
+    br->buf = buf;
+    br->size = size;
+    br->pos = 0;
+    br->len = 0;
+}
+
+// -1 ved slut på filen
+static inline int get_byte(struct ByteReader *br) {
+    if (br->pos == br->len) {
+        br->len = fread(br->buf, 1, br->size, br->in);
+        br->pos = 0;
+        if (br->len == 0)
+            return -1;
+    }
+    return br->buf[br->pos++];
+}
+
+// -1 ved slut på filen eller en varint på mere end 5 bytes
+static inline int get_varint(struct ByteReader *br, uint32_t *v) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int b = get_byte(br);
+        if (b < 0)
+            return -1;
+        result |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <string.h>
+#include "commit.h"
+#include "binio.h"
+
+static void commit_flush(struct CommitWriter *cw) {
+    if (cw->pos)
+        fwrite(cw->buf, 1, cw->pos, cw->out);
+    cw->pos = 0;
+}
+
+struct CommitWriter *commit_open(FILE *out) {
+    struct CommitWriter *cw = calloc(1, sizeof *cw);
+    if (!cw)
+        return NULL;
+    cw->out = out;
+    fwrite(COMMIT_MAGIC, 1, 4, out);
+    return cw;
+}
+
+void commit_emit(struct CommitWriter *cw) {
+    if (cw->pos == sizeof cw->buf)
+        commit_flush(cw);
+    const struct CommitRecord *r = &cw->cur;
+    uint8_t *p = cw->buf + cw->pos;
+    put_u32(p, r->pc);
+    put_u32(p + 4, r->inst);
+    p[8] = r->rd;
+    p[9] = r->flags;
+    p[10] = r->store_size;
+    p[11] = 0;
+    put_u32(p + 12, r->rd_value);
+    put_u32(p + 16, r->store_addr);
+    put_u32(p + 20, r->store_data);
+    cw->pos += COMMIT_RECORD_SIZE;
+    cw->pending = 0;
+}
+
+void commit_close(struct CommitWriter *cw) {
+    if (!cw)
+        return;
+    if (cw->pending)
+        commit_emit(cw);
+    commit_flush(cw);
+    fclose(cw->out);
+    free(cw);
+}
+
+int commit_read_magic(FILE *in) {
+    char magic[4];
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, COMMIT_MAGIC, 4) != 0)
+        return -1;
+    return 0;
+}
+
+int commit_read(FILE *in, struct CommitRecord *rec) {
+    uint8_t p[COMMIT_RECORD_SIZE];
+    size_t got = fread(p, 1, COMMIT_RECORD_SIZE, in);
+    if (got == 0)
+        return 0;
+    if (got != COMMIT_RECORD_SIZE)
+        return -1;
+    rec->pc = get_u32(p);
+    rec->inst = get_u32(p + 4);
+    rec->rd = p[8];
+    rec->flags = p[9];
+    rec->store_size = p[10];
+    rec->rd_value = get_u32(p + 12);
+    rec->store_addr = get_u32(p + 16);
+    rec->store_data = get_u32(p + 20);
+    return 1;
+}
+
+int commit_equal(const struct CommitRecord *a, const struct CommitRecord *b) {
+    return a->pc == b->pc && a->inst == b->inst && a->rd == b->rd && a->flags == b->flags &&
+           a->store_size == b->store_size && a->rd_value == b->rd_value &&
+           a->store_addr == b->store_addr && a->store_data == b->store_data;
+}
@@ -0,0 +1,78 @@
+#ifndef __COMMIT_H__
+#define __COMMIT_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Arkitektonisk commit log (-c): ét record med fast størrelse per udført
+// instruktion, til at sammenligne to simulatorer/engines med simcheck.
+// Formatet er stabilt: COMMIT_MAGIC efterfulgt af records på COMMIT_RECORD_SIZE
+// bytes, alle felter little endian:
+//   u32 pc, u32 instruktion, u8 rd (0 = ingen writeback), u8 flag,
+//   u8 store størrelse (1/2/4), u8 0, u32 rd værdi, u32 store adresse, u32 store data
+// Felter der ikke bruges er 0.
+
+#define COMMIT_MAGIC "RVC1"
+#define COMMIT_RECORD_SIZE 24
+#define COMMIT_BUF_RECORDS 4096
+
+enum {
+    COMMIT_REG   = 1,
+    COMMIT_STORE = 2,
+};
+
+struct CommitRecord {
+    uint32_t pc;
+    uint32_t inst;
+    uint8_t rd;
+    uint8_t flags;
+    uint8_t store_size;
+    uint32_t rd_value;
+    uint32_t store_addr;
+    uint32_t store_data;
+};
+
+struct CommitWriter {
+    FILE *out;
+    struct CommitRecord cur;
+    int pending;
+    size_t pos;
+    uint8_t buf[COMMIT_BUF_RECORDS * COMMIT_RECORD_SIZE];
+};
+
+// NULL ved fejl. Filen lukkes af commit_close.
+struct CommitWriter *commit_open(FILE *out);
+// Skriver sidste record, tømmer bufferen og lukker filen
+void commit_close(struct CommitWriter *cw);
+// Skriver det igangværende record til bufferen
+void commit_emit(struct CommitWriter *cw);
+
+// Starter et nyt record; det forrige er nu komplet
+static inline void commit_begin(struct CommitWriter *cw, uint32_t pc, uint32_t inst) {
+    if (cw->pending)
+        commit_emit(cw);
+    cw->pending = 1;
+    cw->cur = (struct CommitRecord){.pc = pc, .inst = inst};
+}
+
+static inline void commit_reg(struct CommitWriter *cw, uint32_t rd, uint32_t value) {
+    cw->cur.flags |= COMMIT_REG;
+    cw->cur.rd = (uint8_t)rd;
+    cw->cur.rd_value = value;
+}
+
+static inline void commit_store(struct CommitWriter *cw, uint32_t addr, uint32_t data, int size) {
+    cw->cur.flags |= COMMIT_STORE;
+    cw->cur.store_size = (uint8_t)size;
+    cw->cur.store_addr = addr;
+    cw->cur.store_data = size == 4 ? data : data & ((1u << (8 * size)) - 1);
+}
+
+// Læsning. commit_read_magic returnerer 0 hvis filen starter med COMMIT_MAGIC.
+int commit_read_magic(FILE *in);
+// 1 ved et record, 0 ved slut, -1 ved et afkortet record
+int commit_read(FILE *in, struct CommitRecord *rec);
+// 1 hvis de to records er ens
+int commit_equal(const struct CommitRecord *a, const struct CommitRecord *b);
+
+#endif
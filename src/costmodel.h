@@ -0,0 +1,61 @@
+#ifndef __COSTMODEL_H__
+#define __COSTMODEL_H__
+
+#include "simulate.h"
+
+// Simpel cyklusmodel: 1 cyklus per instruktion plus straf for mispredictions,
+// en boble for hvert taget hop og redirect for hop med forkert eller ukendt target.
+// Bruges af både opsummeringen og -json/-csv.
+struct CostModel {
+    int mispredict_penalty;
+    int taken_bubble;
+    int jump_redirect;
+};
+
+// Antal hop der koster et redirect. Med -targets er det dem BTB/RAS/target
+// cache gættede forkert; uden kendes målet for en jalr (retur eller
+// indirekte) ikke før execute, så hver af dem koster et redirect.
+static inline unsigned long long cost_redirects(const struct Stat *stats) {
+    const struct TargetStat *tg = &stats->targets;
+    if (!stats->targets_enabled)
+        return tg->kind[JUMP_RETURN].predictions + tg->kind[JUMP_INDIRECT].predictions;
+    unsigned long long misses = 0;
+    for (int k = 0; k < NUM_JUMP_KINDS; k++)
+        misses += tg->kind[k].mispredictions;
+    return misses;
+}
+
+// Cykler der ikke afhænger af retnings-predictoren: instruktioner, bobler og hop
+static inline unsigned long long cost_base_cycles(const struct CostModel *cm, const struct Stat *stats) {
+    unsigned long long jumps = 0;
+    for (int k = 0; k < NUM_JUMP_KINDS; k++)
+        jumps += stats->targets.kind[k].predictions;
+    // NT fejler netop på de tagne branches
+    unsigned long long taken = stats->nt.mispredictions;
+    return (unsigned long long)(stats->insns - stats->warmup_insns)
+           + (taken + jumps) * cm->taken_bubble
+           + cost_redirects(stats) * cm->jump_redirect;
+}
+
+// Estimerede cykler, CPI og speedup i forhold til NT for én predictor
+struct Cost {
+    unsigned long long cycles;
+    double cpi;
+    double speedup;
+};
+
+static inline struct Cost cost_of(const struct CostModel *cm, const struct Stat *stats,
+                                  const struct PredictorStat *p) {
+    unsigned long long base = cost_base_cycles(cm, stats);
+    unsigned long long cycles = base + p->mispredictions * cm->mispredict_penalty;
+    unsigned long long nt_cycles = base + stats->nt.mispredictions * cm->mispredict_penalty;
+    long insns = stats->insns - stats->warmup_insns;
+    struct Cost c = {
+        cycles,
+        insns ? (double)cycles / insns : 0.0,
+        cycles ? (double)nt_cycles / cycles : 0.0,
+    };
+    return c;
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef __COUNTERS_H__
+#define __COUNTERS_H__
+
+#include <stdint.h>
+
+// Saturerende tællere med 1-4 bits. Koden genereres per bredde med
+// DEFINE_COUNTER_WIDTH, så bredden er en konstant i hver funktion og der
+// ikke er nogen branch på bredden i hot path. ctrW_step_sat/hyst/prob kaldes
+// direkte af kalderen for hver (bredde, politik), uden funktionspointer.
+//
+// Opdateringspolitikker:
+//   COUNTER_SATURATING  +1/-1 og mæt ved 0 og max
+//   COUNTER_HYSTERESIS  som saturating, men et skift af retning hopper
+//                       direkte til den stærke tilstand i den nye retning
+//   COUNTER_PROBABILISTIC  svækkelse er deterministisk, styrkelse sker kun
+//                       med sandsynlighed 1/2 (rnd bit)
+enum CounterPolicy {
+    COUNTER_SATURATING,
+    COUNTER_HYSTERESIS,
+    COUNTER_PROBABILISTIC,
+    NUM_COUNTER_POLICIES
+};
+
+// Politik fra suffikset på step funktionen, fx COUNTER_POLICY(hyst)
+#define COUNTER_POLICY_sat  COUNTER_SATURATING
+#define COUNTER_POLICY_hyst COUNTER_HYSTERESIS
+#define COUNTER_POLICY_prob COUNTER_PROBABILISTIC
+#define COUNTER_POLICY(pol) COUNTER_POLICY_##pol
+
+#define MAX_COUNTER_BITS 4
+
+// 16-bit Galois LFSR, tilfældige bits til den probabilistiske politik
+static inline uint32_t lfsr_next(uint32_t *lfsr) {
+    *lfsr = (*lfsr >> 1) ^ (-(*lfsr & 1u) & 0xB400u);
+    return *lfsr;
+}
+
+#define DEFINE_COUNTER_WIDTH(W)                                                 \
+static inline int ctr##W##_predict(uint8_t c) {                                 \
+    return (c >> ((W) - 1)) & 1;                                                \
+}                                                                               \
+static inline uint8_t ctr##W##_sat(uint8_t c, int taken) {                      \
+    if (taken) {                                                                \
+        if (c < (1u << (W)) - 1) c++;                                           \
+    } else {                                                                    \
+        if (c > 0) c--;                                                         \
+    }                                                                           \
+    return c;                                                                   \
+}                                                                               \
+static inline uint8_t ctr##W##_hyst(uint8_t c, int taken) {                     \
+    const uint8_t weak_nt = (1u << ((W) - 1)) - 1;                              \
+    if (taken && c == weak_nt)                                                  \
+        return (1u << (W)) - 1;                                                 \
+    if (!taken && c == weak_nt + 1)                                             \
+        return 0;                                                               \
+    return ctr##W##_sat(c, taken);                                              \
+}                                                                               \
+static inline uint8_t ctr##W##_prob(uint8_t c, int taken, uint32_t rnd) {       \
+    int pred = ctr##W##_predict(c);                                             \
+    if (pred == taken && (rnd & 1))                                             \
+        return c;                                                               \
+    return ctr##W##_sat(c, taken);                                              \
+}                                                                               \
+/* Et skridt: returnerer forudsigelsen før opdatering */                        \
+static inline int ctr##W##_step_sat(uint8_t *c, int taken, uint32_t *lfsr) {   \
+    (void)lfsr;                                                                 \
+    int pred = ctr##W##_predict(*c);                                            \
+    *c = ctr##W##_sat(*c, taken);                                               \
+    return pred;                                                                \
+}                                                                               \
+static inline int ctr##W##_step_hyst(uint8_t *c, int taken, uint32_t *lfsr) {  \
+    (void)lfsr;                                                                 \
+    int pred = ctr##W##_predict(*c);                                            \
+    *c = ctr##W##_hyst(*c, taken);                                              \
+    return pred;                                                                \
+}                                                                               \
+static inline int ctr##W##_step_prob(uint8_t *c, int taken, uint32_t *lfsr) {  \
+    int pred = ctr##W##_predict(*c);                                            \
+    *c = ctr##W##_prob(*c, taken, lfsr_next(lfsr));                             \
+    return pred;                                                                \
+}
+
+DEFINE_COUNTER_WIDTH(1)
+DEFINE_COUNTER_WIDTH(2)
+DEFINE_COUNTER_WIDTH(3)
+DEFINE_COUNTER_WIDTH(4)
+
+#endif
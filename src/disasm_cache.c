@@ -0,0 +1,32 @@
+#include <stdlib.h>
+#include "disasm_cache.h"
+#include "disassemble.h"
+
+struct DisasmCache *disasm_cache_create(struct symbols *symbols) {
+    struct DisasmCache *c = calloc(1, sizeof *c);
+    if (c)
+        c->symbols = symbols;
+    return c;
+}
+
+void disasm_cache_delete(struct DisasmCache *c) {
+    free(c);
+}
+
+void disasm_cache_write(struct DisasmCache *c, FILE *out, long int insn,
+                        uint32_t pc, uint32_t inst) {
+    struct DisasmCacheEntry *e = &c->entries[(pc >> 2) & ((1u << DISASM_CACHE_BITS) - 1)];
+    if (!e->valid || e->pc != pc || e->inst != inst) {
+        char buf[128];
+        disassemble(pc, inst, buf, sizeof buf, c->symbols);
+        int len = snprintf(e->text, sizeof e->text, "  %08x : %08x   %s\n", pc, inst, buf);
+        if (len >= (int)sizeof e->text)
+            len = sizeof e->text - 1;
+        e->len = (uint16_t)len;
+        e->pc = pc;
+        e->inst = inst;
+        e->valid = 1;
+    }
+    fprintf(out, "%8ld", insn);
+    fwrite(e->text, 1, e->len, out);
+}
@@ -0,0 +1,36 @@
+#ifndef __DISASM_CACHE_H__
+#define __DISASM_CACHE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Cache af færdige -l linjer (uden instruktionsnummer) per pc. Fyldes når en
+// pc logges første gang. En entry gælder kun for det instruktionsord den blev
+// lavet af, så kode der overskrives bliver disassembleret igen.
+
+#define DISASM_CACHE_BITS 12
+#define DISASM_LINE_MAX 160
+
+struct symbols;
+
+struct DisasmCacheEntry {
+    uint32_t pc;
+    uint32_t inst;
+    uint8_t valid;
+    uint16_t len;
+    char text[DISASM_LINE_MAX];     // "  pc : inst   disassembly\n"
+};
+
+struct DisasmCache {
+    struct symbols *symbols;
+    struct DisasmCacheEntry entries[1 << DISASM_CACHE_BITS];
+};
+
+struct DisasmCache *disasm_cache_create(struct symbols *symbols);
+void disasm_cache_delete(struct DisasmCache *c);
+
+// Skriver én -l linje: "%8ld  %08x : %08x   %s\n"
+void disasm_cache_write(struct DisasmCache *c, FILE *out, long int insn,
+                        uint32_t pc, uint32_t inst);
+
+#endif
@@ -0,0 +1,59 @@
+#include "hosttime.h"
+
+static const char *phase_names[NUM_HOST_PHASES] = {
+    "memory", "elf", "symbols", "simulate", "stats", "teardown"
+};
+
+static const char *phase_labels[NUM_HOST_PHASES] = {
+    "memory create", "ELF load", "symbol load", "simulation", "stats output", "teardown"
+};
+
+static double seconds_since(clockid_t clock, const struct timespec *mark, struct timespec *now) {
+    clock_gettime(clock, now);
+    return (double)(now->tv_sec - mark->tv_sec) + (now->tv_nsec - mark->tv_nsec) * 1e-9;
+}
+
+void host_times_init(struct HostTimes *t) {
+    *t = (struct HostTimes){.phase = -1};
+    clock_gettime(CLOCK_MONOTONIC, &t->wall_start);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t->cpu_start);
+}
+
+void host_times_end_phase(struct HostTimes *t) {
+    if (t->phase < 0)
+        return;
+    struct timespec now;
+    t->wall[t->phase] += seconds_since(CLOCK_MONOTONIC, &t->wall_mark, &now);
+    t->cpu[t->phase] += seconds_since(CLOCK_PROCESS_CPUTIME_ID, &t->cpu_mark, &now);
+    t->phase = -1;
+}
+
+void host_times_phase(struct HostTimes *t, enum HostPhase p) {
+    host_times_end_phase(t);
+    t->phase = p;
+    clock_gettime(CLOCK_MONOTONIC, &t->wall_mark);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t->cpu_mark);
+}
+
+void host_times_finish(struct HostTimes *t) {
+    host_times_end_phase(t);
+    struct timespec now;
+    t->wall_total = seconds_since(CLOCK_MONOTONIC, &t->wall_start, &now);
+    t->cpu_total = seconds_since(CLOCK_PROCESS_CPUTIME_ID, &t->cpu_start, &now);
+}
+
+const char *host_phase_name(enum HostPhase p) {
+    return phase_names[p];
+}
+
+void host_times_print(FILE *out, const struct HostTimes *t) {
+    double wall_other = t->wall_total, cpu_other = t->cpu_total;
+    fprintf(out, "\nHost time per phase (seconds):         wall          CPU\n");
+    for (int p = 0; p < NUM_HOST_PHASES; p++) {
+        fprintf(out, "  %-32s %12.6f %12.6f\n", phase_labels[p], t->wall[p], t->cpu[p]);
+        wall_other -= t->wall[p];
+        cpu_other -= t->cpu[p];
+    }
+    fprintf(out, "  %-32s %12.6f %12.6f\n", "other (options, setup)", wall_other, cpu_other);
+    fprintf(out, "  %-32s %12.6f %12.6f\n", "total", t->wall_total, t->cpu_total);
+}
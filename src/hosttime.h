@@ -0,0 +1,44 @@
+#ifndef __HOSTTIME_H__
+#define __HOSTTIME_H__
+
+#include <stdio.h>
+#include <time.h>
+
+// Værtstid per fase af en kørsel, målt med CLOCK_MONOTONIC (wall) og
+// CLOCK_PROCESS_CPUTIME_ID (CPU for alle tråde, inkl. -l skrivetråden).
+// Tid mellem faserne (option parsing, opsætning) tælles som "other".
+
+enum HostPhase {
+    PHASE_MEMORY,       // memory_create
+    PHASE_ELF,          // read_elf
+    PHASE_SYMBOLS,      // symbols_read_from_elf
+    PHASE_SIMULATE,
+    PHASE_STATS,        // opsummering og profiler
+    PHASE_TEARDOWN,     // lukning af traces/logs og nedlæggelse af lager
+    NUM_HOST_PHASES
+};
+
+struct HostTimes {
+    double wall[NUM_HOST_PHASES];
+    double cpu[NUM_HOST_PHASES];
+    double wall_total;
+    double cpu_total;
+    int phase;                  // igangværende fase, -1 = ingen
+    struct timespec wall_start; // start på kørslen
+    struct timespec cpu_start;
+    struct timespec wall_mark;  // start på igangværende fase
+    struct timespec cpu_mark;
+};
+
+void host_times_init(struct HostTimes *t);
+// Afslutter igangværende fase og starter p
+void host_times_phase(struct HostTimes *t, enum HostPhase p);
+// Afslutter igangværende fase uden at starte en ny
+void host_times_end_phase(struct HostTimes *t);
+// Afslutter igangværende fase og sætter totalerne
+void host_times_finish(struct HostTimes *t);
+
+const char *host_phase_name(enum HostPhase p);
+void host_times_print(FILE *out, const struct HostTimes *t);
+
+#endif
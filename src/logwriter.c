@@ -0,0 +1,70 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include "logwriter.h"
+#include "disasm_cache.h"
+
+static void *log_writer_main(void *arg) {
+    struct LogWriter *lw = arg;
+    uint32_t tail = atomic_load_explicit(&lw->tail, memory_order_relaxed);
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&lw->head, memory_order_acquire);
+        if (head == tail) {
+            if (atomic_load_explicit(&lw->done, memory_order_acquire) &&
+                head == atomic_load_explicit(&lw->head, memory_order_acquire))
+                break;
+            // tom ring: giv producer tid til at fylde den
+            struct timespec ts = {0, 50000};
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        // skriv alt der er klar, og frigiv pladserne samlet
+        while (tail != head) {
+            const struct LogRecord *r = &lw->ring[tail & (LOG_RING_SIZE - 1)];
+            disasm_cache_write(lw->cache, lw->out, r->insn, r->pc, r->inst);
+            tail++;
+            if ((tail & 1023) == 0)
+                atomic_store_explicit(&lw->tail, tail, memory_order_release);
+        }
+        atomic_store_explicit(&lw->tail, tail, memory_order_release);
+    }
+    return NULL;
+}
+
+struct LogWriter *log_writer_start(FILE *out, struct symbols *symbols) {
+    struct LogWriter *lw = aligned_alloc(64, sizeof *lw);
+    if (!lw)
+        return NULL;
+    lw->out = out;
+    lw->cache = disasm_cache_create(symbols);
+    atomic_init(&lw->head, 0);
+    atomic_init(&lw->tail, 0);
+    atomic_init(&lw->done, 0);
+    lw->cached_tail = 0;
+    if (!lw->cache || pthread_create(&lw->thread, NULL, log_writer_main, lw) != 0) {
+        disasm_cache_delete(lw->cache);
+        free(lw);
+        return NULL;
+    }
+    return lw;
+}
+
+// Ringen er fuld: vent til skrivetråden har gjort plads
+void log_writer_wait(struct LogWriter *lw) {
+    uint32_t head = atomic_load_explicit(&lw->head, memory_order_relaxed);
+    for (;;) {
+        lw->cached_tail = atomic_load_explicit(&lw->tail, memory_order_acquire);
+        if (head - lw->cached_tail < LOG_RING_SIZE)
+            return;
+        sched_yield();
+    }
+}
+
+void log_writer_stop(struct LogWriter *lw) {
+    if (!lw)
+        return;
+    atomic_store_explicit(&lw->done, 1, memory_order_release);
+    pthread_join(lw->thread, NULL);
+    disasm_cache_delete(lw->cache);
+    free(lw);
+}
@@ -0,0 +1,59 @@
+#ifndef __LOGWRITER_H__
+#define __LOGWRITER_H__
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Asynkron -l log: simuleringstråden lægger faste records i en lock-free
+// single-producer/single-consumer ring, og en skrivetråd disassemblerer og
+// skriver linjerne i samme format som før.
+
+#define LOG_RING_BITS 16
+#define LOG_RING_SIZE (1u << LOG_RING_BITS)
+
+struct LogRecord {
+    long int insn;
+    uint32_t pc;
+    uint32_t inst;
+};
+
+struct symbols;
+struct DisasmCache;
+
+struct LogWriter {
+    FILE *out;
+    struct DisasmCache *cache;
+    pthread_t thread;
+
+    // producer og consumer index på hver sin cache line
+    _Alignas(64) _Atomic uint32_t head;    // næste plads producer skriver
+    uint32_t cached_tail;                  // producerens kopi af tail
+    _Alignas(64) _Atomic uint32_t tail;    // næste plads consumer læser
+    _Atomic int done;
+
+    _Alignas(64) struct LogRecord ring[LOG_RING_SIZE];
+};
+
+// Starter skrivetråden. NULL hvis tråden ikke kunne startes.
+struct LogWriter *log_writer_start(FILE *out, struct symbols *symbols);
+// Venter til alle records er skrevet og stopper tråden. out lukkes ikke.
+void log_writer_stop(struct LogWriter *lw);
+
+// Kaldes af producer når ringen ser fuld ud
+void log_writer_wait(struct LogWriter *lw);
+
+static inline void log_writer_put(struct LogWriter *lw, long int insn, uint32_t pc, uint32_t inst) {
+    uint32_t head = atomic_load_explicit(&lw->head, memory_order_relaxed);
+    if (head - lw->cached_tail == LOG_RING_SIZE) {
+        log_writer_wait(lw);
+    }
+    struct LogRecord *r = &lw->ring[head & (LOG_RING_SIZE - 1)];
+    r->insn = insn;
+    r->pc = pc;
+    r->inst = inst;
+    atomic_store_explicit(&lw->head, head + 1, memory_order_release);
+}
+
+#endif
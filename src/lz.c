@@ -0,0 +1,301 @@
+// fopencookie (glibc)
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include "lz.h"
+#include "binio.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5      // de sidste bytes er altid literals
+#define LZ_CHAIN_DEPTH 32
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *lit, size_t lit_len,
+                             size_t offset, size_t match_len) {
+    uint8_t *token = op++;
+    *token = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4);
+    if (lit_len >= 15)
+        op = put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len == 0)
+        return op;
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t m = match_len - LZ_MIN_MATCH;
+    *token |= (uint8_t)(m < 15 ? m : 15);
+    if (m >= 15)
+        op = put_length(op, m - 15);
+    return op;
+}
+
+size_t lz_compress(const uint8_t *src, size_t n, uint8_t *dst, struct LzTables *t) {
+    // positioner + 1, 0 = tom. chain[pos] er forrige position med samme hash.
+    memset(t->head, 0, sizeof t->head);
+
+    uint8_t *op = dst;
+    size_t ip = 0, anchor = 0;
+    size_t limit = n > LZ_LAST_LITERALS + LZ_MIN_MATCH ? n - LZ_LAST_LITERALS : 0;
+    while (ip + LZ_MIN_MATCH <= limit) {
+        uint32_t seq = read32(src + ip);
+        uint32_t h = lz_hash(seq);
+        size_t cand = t->head[h];
+        t->chain[ip & (LZ_BLOCK_SIZE - 1)] = (uint32_t)cand;
+        t->head[h] = (uint32_t)ip + 1;
+
+        // længste match blandt de nyeste LZ_CHAIN_DEPTH kandidater
+        size_t best_len = 0, best_ref = 0;
+        for (int depth = 0; cand && depth < LZ_CHAIN_DEPTH; depth++) {
+            size_t ref = cand - 1;
+            if (ip - ref > 0xFFFF)
+                break;
+            if (src[ref + best_len] == src[ip + best_len] && read32(src + ref) == seq) {
+                size_t len = LZ_MIN_MATCH;
+                while (ip + len < limit && src[ref + len] == src[ip + len])
+                    len++;
+                if (len > best_len) {
+                    best_len = len;
+                    best_ref = ref;
+                }
+            }
+            cand = t->chain[ref & (LZ_BLOCK_SIZE - 1)];
+        }
+        if (best_len == 0) {
+            ip++;
+            continue;
+        }
+        op = put_sequence(op, src + anchor, ip - anchor, ip - best_ref, best_len);
+        // positionerne inde i matchet kommer også i kæderne
+        for (size_t p = ip + 1; p < ip + best_len && p + LZ_MIN_MATCH <= limit; p++) {
+            uint32_t hp = lz_hash(read32(src + p));
+            t->chain[p & (LZ_BLOCK_SIZE - 1)] = t->head[hp];
+            t->head[hp] = (uint32_t)p + 1;
+        }
+        ip += best_len;
+        anchor = ip;
+    }
+    return put_sequence(op, src + anchor, n - anchor, 0, 0) - dst;
+}
+
+static int get_length(const uint8_t **ip, const uint8_t *end, size_t *len) {
+    uint8_t b;
+    do {
+        if (*ip >= end)
+            return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+int lz_decompress(const uint8_t *src, size_t n, uint8_t *dst, size_t raw_len) {
+    const uint8_t *ip = src, *end = src + n;
+    uint8_t *op = dst, *oend = dst + raw_len;
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && get_length(&ip, end, &lit))
+            return -1;
+        if (lit > (size_t)(end - ip) || lit > (size_t)(oend - op))
+            return -1;
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && get_length(&ip, end, &len))
+            return -1;
+        len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - dst) || len > (size_t)(oend - op))
+            return -1;
+        // match kan overlappe sig selv, så der kopieres byte for byte
+        const uint8_t *m = op - offset;
+        for (size_t i = 0; i < len; i++)
+            op[i] = m[i];
+        op += len;
+    }
+    return op == oend ? 0 : -1;
+}
+
+// Strømme via fopencookie (glibc) eller funopen (BSD, macOS), så log og trace
+// koden skriver til en almindelig FILE. Uden nogen af dem returnerer
+// lz_open_write/lz_open_read NULL, og -z samt læsning af -z filer fejler.
+
+struct LzStream {
+    FILE *file;
+    size_t pos;
+    size_t len;         // kun ved læsning: bytes i buf
+    uint8_t buf[LZ_BLOCK_SIZE];
+    uint8_t comp[LZ_MAX_COMPRESSED(LZ_BLOCK_SIZE)];
+    struct LzTables tables;
+};
+
+static int lz_write_block(struct LzStream *s) {
+    if (s->pos == 0)
+        return 0;
+    uint8_t hdr[8];
+    size_t clen = lz_compress(s->buf, s->pos, s->comp, &s->tables);
+    const uint8_t *data = s->comp;
+    if (clen >= s->pos) {
+        clen = s->pos;
+        data = s->buf;
+    }
+    put_u32(hdr, (uint32_t)s->pos);
+    put_u32(hdr + 4, (uint32_t)clen);
+    if (fwrite(hdr, 1, 8, s->file) != 8 || fwrite(data, 1, clen, s->file) != clen)
+        return -1;
+    s->pos = 0;
+    return 0;
+}
+
+static ssize_t lz_cookie_write(void *cookie, const char *data, size_t size) {
+    struct LzStream *s = cookie;
+    size_t done = 0;
+    while (done < size) {
+        size_t n = LZ_BLOCK_SIZE - s->pos;
+        if (n > size - done)
+            n = size - done;
+        memcpy(s->buf + s->pos, data + done, n);
+        s->pos += n;
+        done += n;
+        if (s->pos == LZ_BLOCK_SIZE && lz_write_block(s) != 0)
+            return -1;
+    }
+    return (ssize_t)size;
+}
+
+static int lz_cookie_close_write(void *cookie) {
+    struct LzStream *s = cookie;
+    int status = lz_write_block(s);
+    if (fclose(s->file) != 0)
+        status = -1;
+    free(s);
+    return status;
+}
+
+static ssize_t lz_cookie_read(void *cookie, char *data, size_t size) {
+    struct LzStream *s = cookie;
+    if (s->pos == s->len) {
+        uint8_t hdr[8];
+        size_t got = fread(hdr, 1, 8, s->file);
+        if (got == 0)
+            return 0;
+        uint32_t raw = get_u32(hdr), clen = get_u32(hdr + 4);
+        if (got != 8 || raw > LZ_BLOCK_SIZE || clen > raw ||
+            fread(s->comp, 1, clen, s->file) != clen)
+            return -1;
+        if (clen == raw)
+            memcpy(s->buf, s->comp, raw);
+        else if (lz_decompress(s->comp, clen, s->buf, raw) != 0)
+            return -1;
+        s->pos = 0;
+        s->len = raw;
+    }
+    size_t n = s->len - s->pos;
+    if (n > size)
+        n = size;
+    memcpy(data, s->buf + s->pos, n);
+    s->pos += n;
+    return (ssize_t)n;
+}
+
+static int lz_cookie_close_read(void *cookie) {
+    struct LzStream *s = cookie;
+    int status = fclose(s->file);
+    free(s);
+    return status;
+}
+
+#if defined(__GLIBC__)
+static FILE *lz_stream_open(struct LzStream *s, int write) {
+    cookie_io_functions_t io = {NULL, NULL, NULL, NULL};
+    if (write) {
+        io.write = lz_cookie_write;
+        io.close = lz_cookie_close_write;
+    } else {
+        io.read = lz_cookie_read;
+        io.close = lz_cookie_close_read;
+    }
+    return fopencookie(s, write ? "w" : "r", io);
+}
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+static int lz_funopen_write(void *cookie, const char *data, int size) {
+    return (int)lz_cookie_write(cookie, data, (size_t)size);
+}
+
+static int lz_funopen_read(void *cookie, char *data, int size) {
+    return (int)lz_cookie_read(cookie, data, (size_t)size);
+}
+
+static FILE *lz_stream_open(struct LzStream *s, int write) {
+    if (write)
+        return funopen(s, NULL, lz_funopen_write, NULL, lz_cookie_close_write);
+    return funopen(s, lz_funopen_read, NULL, NULL, lz_cookie_close_read);
+}
+#else
+static FILE *lz_stream_open(struct LzStream *s, int write) {
+    (void)s;
+    (void)write;
+    (void)lz_cookie_write;
+    (void)lz_cookie_close_write;
+    (void)lz_cookie_read;
+    (void)lz_cookie_close_read;
+    return NULL;
+}
+#endif
+
+FILE *lz_open_write(FILE *out) {
+    if (fwrite(LZ_MAGIC, 1, 4, out) != 4)
+        return NULL;
+    struct LzStream *s = calloc(1, sizeof *s);
+    if (!s)
+        return NULL;
+    s->file = out;
+    FILE *f = lz_stream_open(s, 1);
+    if (!f)
+        free(s);
+    return f;
+}
+
+FILE *lz_open_read(FILE *in) {
+    struct LzStream *s = calloc(1, sizeof *s);
+    if (!s)
+        return NULL;
+    s->file = in;
+    FILE *f = lz_stream_open(s, 0);
+    if (!f)
+        free(s);
+    return f;
+}
+
+int lz_check_magic(FILE *in) {
+    char magic[4];
+    if (fread(magic, 1, 4, in) == 4 && memcmp(magic, LZ_MAGIC, 4) == 0)
+        return 1;
+    rewind(in);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef __LZ_H__
+#define __LZ_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Simpel LZ77 komprimering (LZ4-agtigt format) til -l logs og -t traces.
+// Strømmen er LZ_MAGIC efterfulgt af blokke på højst LZ_BLOCK_SIZE bytes:
+//   u32 rå længde, u32 komprimeret længde, data
+// Er de to længder ens, er blokken gemt ukomprimeret.
+// En blok er en række sekvenser: token (literal længde << 4 | match længde - 4),
+// evt. forlængede længder i 255-trin, literals, 2 bytes offset og match.
+// Sidste sekvens har kun literals.
+
+#define LZ_MAGIC "RVZ1"
+#define LZ_BLOCK_SIZE (1 << 16)
+#define LZ_MAX_COMPRESSED(n) ((n) + (n) / 255 + 16)
+#define LZ_HASH_BITS 14
+
+// Arbejdsplads til lz_compress: hash kæder over blokken
+struct LzTables {
+    uint32_t head[1 << LZ_HASH_BITS];
+    uint32_t chain[LZ_BLOCK_SIZE];
+};
+
+// Returnerer komprimeret længde; dst skal have plads til LZ_MAX_COMPRESSED(n)
+size_t lz_compress(const uint8_t *src, size_t n, uint8_t *dst, struct LzTables *t);
+// Returnerer 0 hvis data fylder præcis raw_len bytes, ellers -1
+int lz_decompress(const uint8_t *src, size_t n, uint8_t *dst, size_t raw_len);
+
+// FILE der komprimerer til out. fclose på den lukker også out.
+// NULL hvis platformen hverken har fopencookie eller funopen (se lz.c).
+FILE *lz_open_write(FILE *out);
+// FILE der dekomprimerer fra in, som skal stå lige efter LZ_MAGIC
+FILE *lz_open_read(FILE *in);
+// Læser magic fra starten af in: 1 hvis komprimeret (in står efter magic),
+// ellers 0 og in spoles tilbage
+int lz_check_magic(FILE *in);
+
+#endif
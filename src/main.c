@@ -2,10 +2,19 @@
 #include "read_elf.h"
 #include "disassemble.h"
 #include "simulate.h"
+#include "profile.h"
+#include "trace.h"
+#include "tracefilter.h"
+#include "lz.h"
+#include "commit.h"
+#include "sampler.h"
+#include "memtrace.h"
+#include "report.h"
+#include "costmodel.h"
+#include "hosttime.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 void terminate(const char *error)
 {
@@ -16,6 +25,45 @@ void terminate(const char *error)
   printf("      sim riscv-elf -d         // disassemble text segment of riscv-elf file to stdout\n");
   printf("      sim riscv-elf -l log     // simulate and log each instruction to file 'log'\n");
   printf("      sim riscv-elf -s log     // simulate and log only summary to file 'log'\n");
+  printf("      sim riscv-elf -l log -window A B  // only log instructions A..B-1 (counted from 1)\n");
+  printf("      sim riscv-elf -l log -range LO HI // only log pc in [LO, HI), may be repeated\n");
+  printf("      sim riscv-elf -l log -func name   // only log inside function 'name', may be repeated\n");
+  printf("      sim riscv-elf -l log -only list   // only log classes in list: alu,load,store,mem,branch,jump,system\n");
+  printf("      sim riscv-elf -t trace   // write a compact binary trace to file 'trace', view it with simtrace\n");
+  printf("      sim riscv-elf -sample N smp      // log every N'th instruction with registers to file 'smp'\n");
+  printf("      sim riscv-elf -sample-rate P smp // ... or each instruction with probability P (0 < P <= 1)\n");
+  printf("      sim riscv-elf -seed S    // random seed for -sample-rate\n");
+  printf("      sim riscv-elf -m mem     // write every load/store (pc, address, size, r/w) to file 'mem', view with simtrace -m\n");
+  printf("      sim riscv-elf -m mem -din // ... as a Dinero din trace (label address) for cache simulators, not with -z\n");
+  printf("      sim riscv-elf -c commits // write a binary commit record per instruction, compare with simcheck\n");
+  printf("      sim riscv-elf -l log -z  // compress -l, -t and -m output, read it back with simtrace\n");
+  printf("      sim riscv-elf -p prof    // write per-branch misprediction profile to file 'prof'\n");
+  printf("      sim riscv-elf -p prof -top N // ... listing the N worst branches (default 20)\n");
+  printf("      sim riscv-elf -gshare-sweep  // also run gShare with every history length per size\n");
+  printf("      sim riscv-elf -counters  // also run bimodal/gShare with other counter widths and policies\n");
+  printf("      sim riscv-elf -classify  // mispredictions per branch class (biased, loop-like, random...)\n");
+  printf("      sim riscv-elf -aliasing  // classify bimodal/gShare mispredictions as aliasing or unpredictable\n");
+  printf("    only NT, BTFNT, bimodal and gShare run by default, add more predictors with:\n");
+  printf("      sim riscv-elf -tage      // TAGE at the storage budget of each gShare size\n");
+  printf("      sim riscv-elf -perceptron // hashed perceptron at the same budgets\n");
+  printf("      sim riscv-elf -tournament // tournament of bimodal and gShare per size\n");
+  printf("      sim riscv-elf -local     // PAg/PAp local history predictors\n");
+  printf("      sim riscv-elf -loop      // loop predictor, standalone and as gShare override\n");
+  printf("      sim riscv-elf -targets   // BTB, RAS and indirect target cache for jal/jalr\n");
+  printf("      sim riscv-elf -all       // all of the above\n");
+  printf("      sim riscv-elf -local -local-config B H P // PAg/PAp with B BHT entries, H history bits, P PHT entries\n");
+  printf("                               // (B, P powers of two, P >= 2^H), may be repeated, replaces the default set\n");
+  printf("      sim riscv-elf -targets -btb S W T // BTB with S sets (2^n), W ways and T-bit tags, 0 = full (256 4 12)\n");
+  printf("      sim riscv-elf -targets -ras D wrap|drop // RAS depth and overflow policy (16 wrap)\n");
+  printf("      sim riscv-elf -targets -itc E H  // indirect target cache with E entries (2^n), H-bit path history (1024 12)\n");
+  printf("      sim riscv-elf -warmup N  // leave the first N branches out of the statistics\n");
+  printf("      sim riscv-elf -interval K ts // write mispredictions per K instructions to file 'ts'\n");
+  printf("      sim riscv-elf -json file // also write all statistics as JSON to 'file'\n");
+  printf("      sim riscv-elf -csv file  // ... or as CSV, one 'name,value' line per number\n");
+  printf("      sim riscv-elf -penalty N -bubble N -redirect N // cycle model: cycles lost per branch\n");
+  printf("                               // misprediction (10), taken branch/jump (1) and jump target miss (10,\n");
+  printf("                               // every jalr without -targets)\n");
+  printf("    options may be combined, e.g. sim riscv-elf -l log -gshare-sweep\n");
   printf("    prog-args: arguments to the simulated program\n");
   printf("               these arguments are provided through argv. Puts '--' in argv[0]\n");
   printf("      sim riscv-elf -- gylletank   // run riscv-elf with 'gylletank' in argv[1]\n");
@@ -65,104 +113,688 @@ void disassemble_to_stdout(struct memory* mem, struct program_info* prog_info, s
   }
 }
 
+static int cmp_itc_misses(const void *a, const void *b)
+{
+  const struct IndirectSite *x = *(const struct IndirectSite *const *)a;
+  const struct IndirectSite *y = *(const struct IndirectSite *const *)b;
+  if (x->itc_misses != y->itc_misses)
+    return x->itc_misses < y->itc_misses ? 1 : -1;
+  return x->pc < y->pc ? -1 : x->pc > y->pc;
+}
+
+// Udskriver indirekte jalr sites sorteret efter target cache misses
+static void print_indirect_sites(FILE *out, const struct TargetStat *tg)
+{
+  const struct IndirectSites *sites = tg->sites;
+  if (sites->count == 0)
+    return;
+  const struct IndirectSite **order = malloc(sites->count * sizeof *order);
+  if (order == NULL)
+    return;
+  int n = 0;
+  for (int i = 0; i < sites->capacity; i++)
+    if (sites->slots[i].execs)
+      order[n++] = &sites->slots[i];
+  qsort(order, n, sizeof *order, cmp_itc_misses);
+  for (int i = 0; i < n; i++) {
+    fprintf(out, "    jalr @ %08x: execs=%llu  BTB misses=%llu  target cache misses=%llu\n",
+            order[i]->pc, order[i]->execs, order[i]->btb_misses, order[i]->itc_misses);
+  }
+  free(order);
+}
+
+// Udskriver gShare sweep: mispredictions for hver historielængde og den bedste per størrelse
+static void print_gshare_sweep(FILE *out, const struct Stat *stats, const int *sizes)
+{
+  fprintf(out, "\ngShare history length sweep (mispredictions per history length):\n");
+  for (int i = 0; i < NUM_PRED_SIZES; i++) {
+    int max_h = 0;
+    while ((1 << max_h) < sizes[i])
+      max_h++;
+    int best = 0;
+    fprintf(out, "  gShare %5d:", sizes[i]);
+    for (int h = 0; h <= max_h; h++) {
+      unsigned long long m = stats->gshare_sweep[i][h].mispredictions;
+      if (m < stats->gshare_sweep[i][best].mispredictions)
+        best = h;
+      fprintf(out, " h%d=%llu", h, m);
+    }
+    fprintf(out, "\n    best history length %d (%llu mispreds, default %d gives %llu)\n",
+            best, (unsigned long long)stats->gshare_sweep[i][best].mispredictions,
+            stats->gshare_hist[i],
+            (unsigned long long)stats->gshare[i].mispredictions);
+  }
+}
+
+// Udskriver bimodal/gShare for hver tællervariant
+static void print_counter_variants(FILE *out, const struct Stat *stats, const int *sizes)
+{
+  static const char *policy_names[] = {"saturating", "hysteresis", "probabilistic"};
+  fprintf(out, "\nCounter variants:\n");
+  for (int k = 0; k < NUM_COUNTER_CONFIGS; k++) {
+    const struct CounterVariantStat *cv = &stats->counter_variants[k];
+    fprintf(out, "  %d-bit init=%d %s:\n", cv->width, cv->init, policy_names[cv->policy]);
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+      fprintf(out, "    %5d entries (%6d bits): Bimodal mispreds=%llu  gShare mispreds=%llu\n",
+              sizes[i], sizes[i] * cv->width,
+              (unsigned long long)cv->bimodal[i].mispredictions,
+              (unsigned long long)cv->gshare[i].mispredictions);
+    }
+  }
+}
+
+// Udskriver aliasing analysen for én tabeltype
+static void print_alias_table(FILE *out, const char *name, const struct AliasStat *as,
+                              const int *sizes)
+{
+  for (int i = 0; i < NUM_PRED_SIZES; i++) {
+    const struct AliasStat *a = &as[i];
+    unsigned long long mispreds = a->destructive + a->unpredictable;
+    fprintf(out, "  %-7s %5d: keys=%llu  entries used=%d shared=%d (max %d keys)  aliased accesses=%.2f%%\n",
+            name, sizes[i], a->keys, a->entries_used, a->entries_shared, a->max_sharing,
+            a->accesses ? 100.0 * a->aliased / a->accesses : 0.0);
+    fprintf(out, "                 mispreds=%llu: destructive=%llu (%.2f%%) unpredictable=%llu  constructive hits=%llu\n",
+            mispreds, a->destructive, mispreds ? 100.0 * a->destructive / mispreds : 0.0,
+            a->unpredictable, a->constructive);
+  }
+}
+
+// Aliasing: destructive mispredictions forsvinder med større tabel eller bedre hash,
+// unpredictable gør ikke
+static void print_aliasing(FILE *out, const struct Stat *stats, const int *sizes)
+{
+  fprintf(out, "\nAliasing (keys: pc for bimodal, pc/history for gShare; compared to one counter per key):\n");
+  print_alias_table(out, "Bimodal", stats->alias_bimodal, sizes);
+  print_alias_table(out, "gShare", stats->alias_gshare, sizes);
+}
+
+// Afslutter en predictor linje med estimerede cykler, CPI og speedup i forhold til NT
+static void print_cost(FILE *out, const struct CostModel *cm, const struct Stat *stats,
+                       const struct PredictorStat *p)
+{
+  struct Cost c = cost_of(cm, stats, p);
+  fprintf(out, "  cycles=%llu  CPI=%.3f  speedup=%.3f\n", c.cycles, c.cpi, c.speedup);
+}
+
 // Helper til at udskrive branch prediction stats
-static void print_branch_stats(FILE *out, const struct Stat *stats)
+static void print_branch_stats(FILE *out, const struct Stat *stats, const struct CostModel *cm)
 {
-  int sizes[NUM_PRED_SIZES] = {256, 1024, 4096, 16384};
+  int sizes[NUM_PRED_SIZES] = { PREDICTOR_SIZES(PRED_SIZE_ENTRY) };
 
+  long insns = stats->insns - stats->warmup_insns;
   fprintf(out, "\nBranch prediction statistics:\n");
+  if (stats->warmup_branches)
+    fprintf(out, "  Warmup: first %llu branches (%ld instructions) not counted\n",
+            stats->warmup_branches, stats->warmup_insns);
+  fprintf(out, "  Cost model: mispredict penalty=%d  taken bubble=%d  jump redirect=%d (%s)  (perfect prediction CPI=%.3f)\n",
+          cm->mispredict_penalty, cm->taken_bubble, cm->jump_redirect,
+          stats->targets_enabled ? "per target miss" : "per jalr, no -targets",
+          insns ? (double)cost_base_cycles(cm, stats) / insns : 0.0);
 
-  fprintf(out, "  NT:    preds=%llu  mispreds=%llu\n",
+  fprintf(out, "  NT:    preds=%llu  mispreds=%llu",
           (unsigned long long)stats->nt.predictions,
           (unsigned long long)stats->nt.mispredictions);
+  print_cost(out, cm, stats, &stats->nt);
 
-  fprintf(out, "  BTFNT: preds=%llu  mispreds=%llu\n",
+  fprintf(out, "  BTFNT: preds=%llu  mispreds=%llu",
           (unsigned long long)stats->btfnt.predictions,
           (unsigned long long)stats->btfnt.mispredictions);
+  print_cost(out, cm, stats, &stats->btfnt);
 
   for (int i = 0; i < NUM_PRED_SIZES; i++) {
-    fprintf(out, "  Bimodal %5d: preds=%llu  mispreds=%llu\n",
+    fprintf(out, "  Bimodal %5d: preds=%llu  mispreds=%llu",
             sizes[i],
             (unsigned long long)stats->bimodal[i].predictions,
             (unsigned long long)stats->bimodal[i].mispredictions);
+    print_cost(out, cm, stats, &stats->bimodal[i]);
 
-    fprintf(out, "  gShare  %5d: preds=%llu  mispreds=%llu\n",
+    fprintf(out, "  gShare  %5d: preds=%llu  mispreds=%llu",
             sizes[i],
             (unsigned long long)stats->gshare[i].predictions,
             (unsigned long long)stats->gshare[i].mispredictions);
+    print_cost(out, cm, stats, &stats->gshare[i]);
+
+    if (stats->tournament_enabled) {
+      const struct TournamentStat *ts = &stats->tournament[i];
+      fprintf(out, "  Tourn   %5d: preds=%llu  mispreds=%llu  (bimodal chosen=%llu correct=%llu, gShare chosen=%llu correct=%llu)",
+              sizes[i],
+              (unsigned long long)ts->pred.predictions,
+              (unsigned long long)ts->pred.mispredictions,
+              (unsigned long long)ts->chose_bimodal,
+              (unsigned long long)ts->bimodal_correct,
+              (unsigned long long)ts->chose_gshare,
+              (unsigned long long)ts->gshare_correct);
+      print_cost(out, cm, stats, &ts->pred);
+    }
+
+    if (stats->tage_enabled) {
+      fprintf(out, "  TAGE    %5d: preds=%llu  mispreds=%llu  (%d bits)",
+              sizes[i],
+              (unsigned long long)stats->tage[i].predictions,
+              (unsigned long long)stats->tage[i].mispredictions,
+              stats->tage_bits[i]);
+      print_cost(out, cm, stats, &stats->tage[i]);
+    }
+
+    if (stats->perceptron_enabled) {
+      fprintf(out, "  Percep  %5d: preds=%llu  mispreds=%llu  (%d bits, hist %d)",
+              sizes[i],
+              (unsigned long long)stats->perceptron[i].predictions,
+              (unsigned long long)stats->perceptron[i].mispredictions,
+              stats->perceptron_bits[i], stats->perceptron_hist[i]);
+      print_cost(out, cm, stats, &stats->perceptron[i]);
+    }
+  }
+
+  for (int i = 0; i < stats->num_local; i++) {
+    const struct LocalStat *ls = &stats->local[i];
+    fprintf(out, "  %s bht=%5d hist=%2d pht=%5d: preds=%llu  mispreds=%llu",
+            ls->pht_entries == (1 << ls->hist_bits) ? "PAg" : "PAp",
+            ls->bht_entries, ls->hist_bits, ls->pht_entries,
+            (unsigned long long)ls->pred.predictions,
+            (unsigned long long)ls->pred.mispredictions);
+    print_cost(out, cm, stats, &ls->pred);
   }
+
+  if (stats->loop_enabled) {
+    const struct LoopStat *lp = &stats->loop;
+    fprintf(out, "  Loop (%d entries): confident preds=%llu (%.2f%% of branches)  mispreds=%llu\n",
+            lp->entries,
+            (unsigned long long)lp->confident.predictions,
+            stats->nt.predictions ? 100.0 * lp->confident.predictions / stats->nt.predictions : 0.0,
+            (unsigned long long)lp->confident.mispredictions);
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+      fprintf(out, "  gShare+Loop %5d: preds=%llu  mispreds=%llu",
+              sizes[i],
+              (unsigned long long)lp->gshare_override[i].predictions,
+              (unsigned long long)lp->gshare_override[i].mispredictions);
+      print_cost(out, cm, stats, &lp->gshare_override[i]);
+    }
+  }
+
+  if (stats->gshare_sweep_enabled)
+    print_gshare_sweep(out, stats, sizes);
+  if (stats->counter_variants_enabled)
+    print_counter_variants(out, stats, sizes);
+  if (stats->aliasing_enabled)
+    print_aliasing(out, stats, sizes);
+
+  const struct TargetStat *tg = &stats->targets;
+  static const char *kind_names[NUM_JUMP_KINDS] = {"Direct", "Call", "Return", "Indirect"};
+  if (!stats->targets_enabled) {
+    fprintf(out, "\nJumps (no target prediction, see -targets):");
+    for (int k = 0; k < NUM_JUMP_KINDS; k++)
+      fprintf(out, "  %s=%llu", kind_names[k], (unsigned long long)tg->kind[k].predictions);
+    fprintf(out, "\n");
+    return;
+  }
+  fprintf(out, "\nJump target prediction (BTB %d sets x %d ways, %d-bit tags, RAS depth %d %s):\n",
+          tg->btb_sets, tg->btb_ways, tg->btb_tag_bits, tg->ras_depth,
+          tg->ras_wrap ? "wrap" : "drop");
+  for (int k = 0; k < NUM_JUMP_KINDS; k++) {
+    unsigned long long n = tg->kind[k].predictions;
+    unsigned long long hits = n - tg->kind[k].mispredictions;
+    fprintf(out, "  %-8s: jumps=%llu  target hits=%llu  misses=%llu  (%.2f%% hit)\n",
+            kind_names[k], n, hits, (unsigned long long)tg->kind[k].mispredictions,
+            n ? 100.0 * hits / n : 0.0);
+  }
+  fprintf(out, "  RAS overflows=%llu  underflows=%llu\n",
+          tg->ras_overflows, tg->ras_underflows);
+  fprintf(out, "  Indirect target cache (%d entries, %d-bit path history): jumps=%llu  misses=%llu\n",
+          tg->itc_entries, tg->itc_hist_bits,
+          (unsigned long long)tg->itc.predictions,
+          (unsigned long long)tg->itc.mispredictions);
+  print_indirect_sites(out, tg);
+}
+
+static int is_pow2(int x)
+{
+  return x > 0 && (x & (x - 1)) == 0;
 }
 
 int main(int argc, char *argv[])
 {
+  struct HostTimes times;
+  host_times_init(&times);
+  host_times_phase(&times, PHASE_MEMORY);
   struct memory *mem = memory_create();
+  host_times_end_phase(&times);
   argc = pass_args_to_program(mem, argc, argv);
-  if (argc == 2 || argc == 3 || argc == 4)
+  if (argc >= 2)
   {
     FILE *log_file = NULL;
     FILE *prof_file = NULL;
-    if (argc == 4 && !strcmp(argv[2], "-l"))
+    const char *summary_name = NULL;
+    int disassemble_only = 0;
+    int top_n = 20;
+    int classify = 0;
+    int compress = 0;
+    FILE *trace_file = NULL;
+    FILE *sample_file = NULL;
+    FILE *mem_file = NULL;
+    FILE *report_file = NULL;
+    enum ReportFormat report_format = REPORT_JSON;
+    enum MemTraceFormat mem_format = MEMTRACE_COMPACT;
+    long sample_period = 0;
+    double sample_rate = 0;
+    unsigned long long sample_seed = 0;
+    struct TraceFilter filter = {0};
+    int use_filter = 0;
+    const char *filter_funcs[MAX_FILTER_RANGES];
+    int num_filter_funcs = 0;
+    int target_geometry = 0;
+    struct SimOptions opts = {.target_cfg = {256, 4, 12, 16, 1, 1024, 12}};
+    struct CostModel cost = {10, 1, 10};
+    for (int i = 2; i < argc; i++)
     {
-      log_file = fopen(argv[3], "w");
-      if (log_file == NULL)
+      if (!strcmp(argv[i], "-d"))
       {
-        terminate("Could not open logfile, terminating.");
+        disassemble_only = 1;
       }
-    }
-    if (argc == 4 && !strcmp(argv[2], "-p"))
-    {
-      prof_file = fopen(argv[3], "w");
-      if (prof_file == NULL)
+      else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+      {
+        log_file = fopen(argv[++i], "w");
+        if (log_file == NULL)
+        {
+          terminate("Could not open logfile, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      {
+        trace_file = fopen(argv[++i], "wb");
+        if (trace_file == NULL)
+        {
+          terminate("Could not open trace file, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      {
+        FILE *commit_file = fopen(argv[++i], "wb");
+        if (commit_file == NULL || (opts.commit = commit_open(commit_file)) == NULL)
+        {
+          terminate("Could not open commit log, terminating.");
+        }
+      }
+      else if ((!strcmp(argv[i], "-sample") || !strcmp(argv[i], "-sample-rate")) && i + 2 < argc)
+      {
+        if (sample_file)
+        {
+          terminate("Only one of -sample and -sample-rate may be given, terminating.");
+        }
+        if (!strcmp(argv[i], "-sample"))
+          sample_period = atol(argv[++i]);
+        else
+          sample_rate = atof(argv[++i]);
+        sample_file = fopen(argv[++i], "w");
+        if (sample_file == NULL || (sample_period <= 0 && !(sample_rate > 0 && sample_rate <= 1.0)))
+        {
+          terminate("Could not open sample file or bad sample rate, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-seed") && i + 1 < argc)
+      {
+        sample_seed = strtoull(argv[++i], NULL, 0);
+      }
+      else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+      {
+        mem_file = fopen(argv[++i], "wb");
+        if (mem_file == NULL)
+        {
+          terminate("Could not open memory trace file, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-din"))
+      {
+        mem_format = MEMTRACE_DIN;
+      }
+      else if ((!strcmp(argv[i], "-json") || !strcmp(argv[i], "-csv")) && i + 1 < argc)
+      {
+        report_format = !strcmp(argv[i], "-json") ? REPORT_JSON : REPORT_CSV;
+        report_file = fopen(argv[++i], "w");
+        if (report_file == NULL)
+        {
+          terminate("Could not open statistics file, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-z"))
+      {
+        compress = 1;
+      }
+      else if (!strcmp(argv[i], "-window") && i + 2 < argc)
+      {
+        filter.start = atol(argv[++i]);
+        filter.end = atol(argv[++i]);
+        if (filter.start < 1 || filter.end <= filter.start)
+        {
+          terminate("-window A B needs 1 <= A < B");
+        }
+        use_filter = 1;
+      }
+      else if (!strcmp(argv[i], "-range") && i + 2 < argc)
+      {
+        uint32_t lo = strtoul(argv[i + 1], NULL, 0);
+        uint32_t hi = strtoul(argv[i + 2], NULL, 0);
+        i += 2;
+        if (lo >= hi)
+        {
+          terminate("-range needs LO < HI, terminating.");
+        }
+        if (filter_add_range(&filter, lo, hi) != 0)
+        {
+          terminate("Too many pc ranges");
+        }
+        use_filter = 1;
+      }
+      else if (!strcmp(argv[i], "-func") && i + 1 < argc)
+      {
+        // slås op når symbolerne er læst
+        if (num_filter_funcs == MAX_FILTER_RANGES)
+        {
+          terminate("Too many pc ranges");
+        }
+        filter_funcs[num_filter_funcs++] = argv[++i];
+        use_filter = 1;
+      }
+      else if (!strcmp(argv[i], "-only") && i + 1 < argc)
+      {
+        if (filter_set_classes(&filter, argv[++i]) != 0)
+        {
+          terminate("Unknown instruction class");
+        }
+        use_filter = 1;
+      }
+      else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+      {
+        prof_file = fopen(argv[++i], "w");
+        if (prof_file == NULL)
+        {
+          terminate("Could not open file for exec profile, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      {
+        summary_name = argv[++i];
+      }
+      else if (!strcmp(argv[i], "-top") && i + 1 < argc)
+      {
+        top_n = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "-penalty") && i + 1 < argc)
+      {
+        cost.mispredict_penalty = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "-bubble") && i + 1 < argc)
+      {
+        cost.taken_bubble = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "-redirect") && i + 1 < argc)
+      {
+        cost.jump_redirect = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "-gshare-sweep"))
+      {
+        opts.gshare_sweep = 1;
+      }
+      else if (!strcmp(argv[i], "-counters"))
+      {
+        opts.counter_variants = 1;
+      }
+      else if (!strcmp(argv[i], "-warmup") && i + 1 < argc)
+      {
+        opts.warmup = strtoull(argv[++i], NULL, 10);
+      }
+      else if (!strcmp(argv[i], "-interval") && i + 2 < argc)
+      {
+        opts.interval = atol(argv[++i]);
+        opts.interval_file = fopen(argv[++i], "w");
+        if (opts.interval <= 0 || opts.interval_file == NULL)
+        {
+          terminate("Could not open file for interval snapshots, terminating.");
+        }
+      }
+      else if (!strcmp(argv[i], "-classify"))
+      {
+        classify = 1;
+      }
+      else if (!strcmp(argv[i], "-aliasing"))
+      {
+        opts.aliasing = 1;
+      }
+      else if (!strcmp(argv[i], "-tage"))
+      {
+        opts.tage = 1;
+      }
+      else if (!strcmp(argv[i], "-perceptron"))
+      {
+        opts.perceptron = 1;
+      }
+      else if (!strcmp(argv[i], "-tournament"))
+      {
+        opts.tournament = 1;
+      }
+      else if (!strcmp(argv[i], "-local"))
+      {
+        opts.local = 1;
+      }
+      else if (!strcmp(argv[i], "-loop"))
+      {
+        opts.loop = 1;
+      }
+      else if (!strcmp(argv[i], "-targets"))
+      {
+        opts.targets = 1;
+      }
+      else if (!strcmp(argv[i], "-local-config") && i + 3 < argc)
+      {
+        if (opts.num_local_cfg == MAX_LOCAL_CONFIGS)
+        {
+          terminate("Too many local predictor configs");
+        }
+        struct LocalConfig *lc = &opts.local_cfg[opts.num_local_cfg++];
+        lc->bht_entries = atoi(argv[++i]);
+        lc->hist_bits = atoi(argv[++i]);
+        lc->pht_entries = atoi(argv[++i]);
+        if (!is_pow2(lc->bht_entries) || lc->bht_entries > (1 << 20) || lc->hist_bits < 1 || lc->hist_bits > 16
+            || !is_pow2(lc->pht_entries) || lc->pht_entries > (1 << 24) || lc->pht_entries < (1 << lc->hist_bits))
+        {
+          terminate("Bad local predictor config: BHT up to 2^20 and PHT up to 2^24 entries, powers of two, 1-16 history bits, PHT >= 2^history");
+        }
+      }
+      else if (!strcmp(argv[i], "-btb") && i + 3 < argc)
+      {
+        target_geometry = 1;
+        struct TargetConfig *tc = &opts.target_cfg;
+        tc->btb_sets = atoi(argv[++i]);
+        tc->btb_ways = atoi(argv[++i]);
+        tc->btb_tag_bits = atoi(argv[++i]);
+        if (!is_pow2(tc->btb_sets) || tc->btb_sets > (1 << 20) || tc->btb_ways < 1 || tc->btb_ways > 64
+            || tc->btb_tag_bits < 0 || tc->btb_tag_bits > 30)
+        {
+          terminate("Bad BTB geometry: sets must be a power of two up to 2^20, 1-64 ways, 0-30 tag bits");
+        }
+      }
+      else if (!strcmp(argv[i], "-ras") && i + 2 < argc)
+      {
+        target_geometry = 1;
+        opts.target_cfg.ras_depth = atoi(argv[++i]);
+        i++;
+        if (!strcmp(argv[i], "wrap"))
+          opts.target_cfg.ras_wrap = 1;
+        else if (!strcmp(argv[i], "drop"))
+          opts.target_cfg.ras_wrap = 0;
+        else
+          terminate("RAS overflow policy must be 'wrap' or 'drop'");
+        if (opts.target_cfg.ras_depth < 1 || opts.target_cfg.ras_depth > 4096)
+        {
+          terminate("Bad RAS depth, must be 1-4096");
+        }
+      }
+      else if (!strcmp(argv[i], "-itc") && i + 2 < argc)
       {
-        terminate("Could not open file for exec profile, terminating.");
+        target_geometry = 1;
+        opts.target_cfg.itc_entries = atoi(argv[++i]);
+        opts.target_cfg.itc_hist_bits = atoi(argv[++i]);
+        if (!is_pow2(opts.target_cfg.itc_entries) || opts.target_cfg.itc_entries > (1 << 24)
+            || opts.target_cfg.itc_hist_bits < 0 || opts.target_cfg.itc_hist_bits > 31)
+        {
+          terminate("Bad indirect target cache: entries must be a power of two up to 2^24, 0-31 history bits");
+        }
       }
+      else if (!strcmp(argv[i], "-all"))
+      {
+        opts.tage = opts.perceptron = opts.tournament = 1;
+        opts.local = opts.loop = opts.targets = 1;
+      }
+      else
+      {
+        terminate("Unknown or incomplete simulator option");
+      }
+    }
+    if (mem_format == MEMTRACE_DIN && !mem_file)
+    {
+      terminate("-din needs -m");
+    }
+    if (mem_format == MEMTRACE_DIN && compress)
+    {
+      terminate("-din writes plain text for Dinero and cannot be combined with -z");
+    }
+    if (use_filter && !log_file)
+    {
+      terminate("-window, -range, -func and -only need -l");
+    }
+    if (opts.num_local_cfg && !opts.local)
+    {
+      terminate("-local-config needs -local");
+    }
+    if (target_geometry && !opts.targets)
+    {
+      terminate("-btb, -ras and -itc need -targets");
+    }
+    if (compress && log_file)
+    {
+      if ((log_file = lz_open_write(log_file)) == NULL)
+        terminate("Could not set up log compression, terminating.");
+    }
+    if (trace_file)
+    {
+      if (compress)
+        trace_file = lz_open_write(trace_file);
+      if (trace_file == NULL || (opts.trace = trace_open(trace_file)) == NULL)
+        terminate("Could not open trace file, terminating.");
+    }
+    if (mem_file)
+    {
+      if (compress)
+        mem_file = lz_open_write(mem_file);
+      if (mem_file == NULL || (opts.memtrace = memtrace_open(mem_file, mem_format)) == NULL)
+        terminate("Could not open memory trace file, terminating.");
     }
     struct program_info prog_info;
+    host_times_phase(&times, PHASE_ELF);
     int status = read_elf(mem, &prog_info, argv[1], log_file);
     if (status) exit(status);
+    host_times_phase(&times, PHASE_SYMBOLS);
     // The use of symbols provide for a nicer disassembly, but their us in A4 is optional,
     // so feel free to remove/ignore setup and use of symbols.
     struct symbols* symbols = symbols_read_from_elf(argv[1]);
     if (symbols == NULL) {
       exit(-1);
     }
-    if (argc == 3 && !strcmp(argv[2], "-d")) {
+    host_times_end_phase(&times);
+    if (disassemble_only) {
       // disassemble text segment to stdout
       disassemble_to_stdout(mem, &prog_info, symbols);
       exit(0);
     }
+    for (int i = 0; i < num_filter_funcs; i++)
+    {
+      if (filter_add_function(&filter, symbols, filter_funcs[i]) != 0)
+      {
+        printf("No function named %s\n", filter_funcs[i]);
+        terminate("Unknown function in -func");
+      }
+    }
+    if (use_filter)
+      opts.log_filter = &filter;
+    if (sample_file)
+    {
+      opts.sampler = sampler_create(sample_file, sample_period, sample_rate, sample_seed, symbols);
+      if (!opts.sampler)
+        terminate("Could not set up sampling, terminating.");
+    }
+    if (prof_file || classify)
+    {
+      opts.profile = profile_create(prog_info.text_start, prog_info.text_end);
+      if (!opts.profile)
+        terminate("Could not set up the branch profile, terminating.");
+    }
     int start_addr = prog_info.start;
-    clock_t before = clock();
-    struct Stat stats = simulate(mem, start_addr, log_file, symbols);
+    host_times_phase(&times, PHASE_SIMULATE);
+    struct Stat stats = simulate(mem, start_addr, log_file, symbols, &opts);
+    host_times_phase(&times, PHASE_STATS);
     long int num_insns = stats.insns;
-    clock_t after = clock();
-    int ticks = after - before;
-    double mips = (1.0 * num_insns * CLOCKS_PER_SEC) / ticks / 1000000;
-    if (argc == 4 && !strcmp(argv[2], "-s"))
+    double mips = num_insns / times.wall[PHASE_SIMULATE] / 1000000;
+    FILE *summary_file = NULL;
+    if (summary_name)
     {
-      log_file = fopen(argv[3], "w");
-      if (log_file == NULL)
+      summary_file = fopen(summary_name, "w");
+      if (summary_file == NULL)
       {
         terminate("Could not open logfile, terminating.");
       }
     }
-    if (log_file)
+    // opsummeringen samles i en buffer, så log og traces kan lukkes indenfor
+    // teardown og kun tidstabellen og -json/-csv skrives efter målingen
+    char *summary = NULL;
+    size_t summary_len = 0;
+    FILE *out = open_memstream(&summary, &summary_len);
+    if (out == NULL)
     {
-      fprintf(log_file, "\nSimulated %ld instructions in %d host ticks (%f MIPS)\n",
-              num_insns, ticks, mips);
-      print_branch_stats(log_file, &stats);
-      fclose(log_file);
+      terminate("Could not allocate the summary, terminating.");
     }
-    else
+    fprintf(out, "\nSimulated %ld instructions in %.6f s wall, %.6f s CPU (%f MIPS)\n",
+            num_insns, times.wall[PHASE_SIMULATE], times.cpu[PHASE_SIMULATE], mips);
+    print_branch_stats(out, &stats, &cost);
+    if (classify)
+      profile_print_classes(out, opts.profile);
+    fclose(out);
+    if (prof_file)
     {
-      printf("\nSimulated %ld instructions in %d host ticks (%f MIPS)\n",
-             num_insns, ticks, mips);
-      print_branch_stats(stdout, &stats);
+      if (profile_print(prof_file, opts.profile, symbols, top_n, PROF_GSHARE) != 0)
+        terminate("Could not write the branch profile, terminating.");
+      fclose(prof_file);
     }
+    host_times_phase(&times, PHASE_TEARDOWN);
+    if (opts.interval_file)
+      fclose(opts.interval_file);
+    trace_close(opts.trace);
+    commit_close(opts.commit);
+    memtrace_close(opts.memtrace);
+    sampler_close(opts.sampler, num_insns);
+    // uden -s står opsummeringen sidst i -l loggen, som så flushes her og
+    // lukkes efter tidstabellen
+    out = summary_file ? summary_file : log_file ? log_file : stdout;
+    if (log_file && log_file != out)
+      fclose(log_file);
+    fwrite(summary, 1, summary_len, out);
+    free(summary);
+    fflush(out);
     memory_delete(mem);
+    host_times_finish(&times);
+    host_times_print(out, &times);
+    if (out != stdout)
+      fclose(out);
+    if (report_file)
+    {
+      struct ReportRun run = {argv[1], mips, &times, &cost, symbols, prof_file != NULL};
+      report_write(report_file, report_format, &run, &stats, opts.profile);
+      fclose(report_file);
+    }
+    profile_delete(opts.profile);
+    indirect_sites_delete(stats.targets.sites);
   }
   else {
     terminate("Missing operands");
     memory_delete(mem);
   }
-}
\ No newline at end of file
+}
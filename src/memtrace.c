@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <string.h>
+#include "memtrace.h"
+
+// log2 af 1, 2 og 4
+static inline int size_code(int size) {
+    return size == 4 ? 2 : size == 2 ? 1 : 0;
+}
+
+struct MemTraceWriter *memtrace_open(FILE *out, enum MemTraceFormat format) {
+    struct MemTraceWriter *mw = calloc(1, sizeof *mw);
+    if (!mw)
+        return NULL;
+    mw->out = out;
+    mw->format = format;
+    if (format == MEMTRACE_COMPACT) {
+        memcpy(mw->buf, MEMTRACE_MAGIC, 4);
+        mw->pos = 4;
+    }
+    return mw;
+}
+
+void memtrace_flush(struct MemTraceWriter *mw) {
+    if (mw->pos)
+        fwrite(mw->buf, 1, mw->pos, mw->out);
+    mw->pos = 0;
+}
+
+void memtrace_close(struct MemTraceWriter *mw) {
+    if (!mw)
+        return;
+    memtrace_flush(mw);
+    fclose(mw->out);
+    free(mw);
+}
+
+void memtrace_encode(struct MemTraceWriter *mw, uint32_t pc, uint32_t addr, int size, int write) {
+    uint8_t *p = mw->buf + mw->pos;
+    if (mw->format == MEMTRACE_DIN) {
+        // "0 1fff0" uden foranstillede nuller, som dinero selv skriver det
+        static const char hex[] = "0123456789abcdef";
+        *p++ = write ? '1' : '0';
+        *p++ = ' ';
+        int shift = 28;
+        while (shift > 0 && (addr >> shift) == 0)
+            shift -= 4;
+        for (; shift >= 0; shift -= 4)
+            *p++ = hex[(addr >> shift) & 0xf];
+        *p++ = '\n';
+    } else {
+        *p++ = (uint8_t)((write ? MEMTRACE_WRITE : 0) | size_code(size) << 1);
+        p = put_varint(p, zigzag((int32_t)(pc - mw->prev_pc)));
+        p = put_varint(p, zigzag((int32_t)(addr - mw->prev_addr)));
+        mw->prev_pc = pc;
+        mw->prev_addr = addr;
+    }
+    mw->pos = p - mw->buf;
+    mw->records++;
+}
+
+struct MemTraceReader *memtrace_reader_open(FILE *in) {
+    char magic[4];
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, MEMTRACE_MAGIC, 4) != 0)
+        return NULL;
+    struct MemTraceReader *mr = calloc(1, sizeof *mr);
+    if (mr)
+        byte_reader_init(&mr->rd, in, mr->buf, MEMTRACE_BUF_SIZE);
+    return mr;
+}
+
+void memtrace_reader_close(struct MemTraceReader *mr) {
+    free(mr);
+}
+
+int memtrace_read(struct MemTraceReader *mr, struct MemAccess *rec) {
+    int flags = get_byte(&mr->rd);
+    if (flags < 0)
+        return 0;
+    if (flags > (MEMTRACE_WRITE | 2 << 1))
+        return -1;
+    uint32_t pc_delta, addr_delta;
+    if (get_varint(&mr->rd, &pc_delta) || get_varint(&mr->rd, &addr_delta))
+        return -1;
+    mr->prev_pc += (uint32_t)unzigzag(pc_delta);
+    mr->prev_addr += (uint32_t)unzigzag(addr_delta);
+    rec->pc = mr->prev_pc;
+    rec->addr = mr->prev_addr;
+    rec->size = 1 << (flags >> 1);
+    rec->write = flags & MEMTRACE_WRITE;
+    return 1;
+}
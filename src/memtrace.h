@@ -0,0 +1,74 @@
+#ifndef __MEMTRACE_H__
+#define __MEMTRACE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include "binio.h"
+
+// Trace af alle load/store adresser (-m) til cache og prefetcher studier.
+// To formater:
+//   MEMTRACE_DIN      Dinero "din" tekst: "label adresse" per linje, label 0 = læs,
+//                     1 = skriv, adressen hex. Kan læses af dineroIV -informat d og
+//                     de fleste andre cache simulatorer. Størrelse og pc kommer ikke med.
+//   MEMTRACE_COMPACT  MEMTRACE_MAGIC efterfulgt af ét record per tilgang:
+//                       flag byte (MEMTRACE_WRITE | log2(størrelse) << 1)
+//                       zigzag varint af pc - forrige pc
+//                       zigzag varint af adresse - forrige adresse
+//                     Læses med memtrace_read, eller vises med simtrace -m.
+
+#define MEMTRACE_MAGIC "RVM1"
+#define MEMTRACE_BUF_SIZE (1 << 16)
+#define MEMTRACE_MAX_RECORD 20     // længste record i begge formater
+
+enum MemTraceFormat { MEMTRACE_COMPACT, MEMTRACE_DIN };
+
+enum {
+    MEMTRACE_WRITE = 1,
+};
+
+struct MemAccess {
+    uint32_t pc;
+    uint32_t addr;
+    int size;           // 1, 2 eller 4
+    int write;
+};
+
+struct MemTraceWriter {
+    FILE *out;
+    enum MemTraceFormat format;
+    uint32_t prev_pc;
+    uint32_t prev_addr;
+    unsigned long long records;
+    size_t pos;
+    uint8_t buf[MEMTRACE_BUF_SIZE];
+};
+
+struct MemTraceReader {
+    struct ByteReader rd;
+    uint32_t prev_pc;
+    uint32_t prev_addr;
+    uint8_t buf[MEMTRACE_BUF_SIZE];
+};
+
+// NULL ved fejl. Filen lukkes af memtrace_close.
+struct MemTraceWriter *memtrace_open(FILE *out, enum MemTraceFormat format);
+// Tømmer bufferen og lukker filen
+void memtrace_close(struct MemTraceWriter *mw);
+
+void memtrace_flush(struct MemTraceWriter *mw);
+void memtrace_encode(struct MemTraceWriter *mw, uint32_t pc, uint32_t addr, int size, int write);
+
+static inline void memtrace_access(struct MemTraceWriter *mw, uint32_t pc, uint32_t addr,
+                                   int size, int write) {
+    if (mw->pos > MEMTRACE_BUF_SIZE - MEMTRACE_MAX_RECORD)
+        memtrace_flush(mw);
+    memtrace_encode(mw, pc, addr, size, write);
+}
+
+// Kun MEMTRACE_COMPACT. NULL hvis filen ikke er et memory trace.
+struct MemTraceReader *memtrace_reader_open(FILE *in);
+void memtrace_reader_close(struct MemTraceReader *mr);
+// 1 ved et record, 0 ved slut, -1 ved fejl i filen
+int memtrace_read(struct MemTraceReader *mr, struct MemAccess *rec);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef __PREDICTOR_CONFIG_H__
+#define __PREDICTOR_CONFIG_H__
+
+// Standard konfiguration af de tabelbaserede predictors. For hver linje
+// instansieres bimodal, gShare, tournament, gShare+loop, TAGE og perceptron:
+//   X(index, entries, gShare historiebits, perceptron historielængde)
+// index er 0..n-1, hvert én gang, og bruges som konstant tabelindex.
+// entries skal være 2^n og højst 2^MAX_GSHARE_HIST. TAGE og perceptron får
+// samme storage budget som gShare (2 bits per entry).
+//
+// En anden konfiguration bygges med: make config CONFIG=min_config.h
+#define PREDICTOR_SIZES(X)  \
+    X(0,   256,  8, 16)     \
+    X(1,  1024, 10, 24)     \
+    X(2,  4096, 12, 32)     \
+    X(3, 16384, 14, 48)
+
+#define MAX_GSHARE_HIST 14      // log2 af største tabel
+
+#endif
@@ -0,0 +1,624 @@
+#include <stdlib.h>
+#include <string.h>
+#include "predictors.h"
+
+// Hjælpefunktion: floor(log2(x)), -1 for x <= 0
+static int floor_log2(int x) {
+    int l = -1;
+    while (x > 0) {
+        x >>= 1;
+        l++;
+    }
+    return l;
+}
+
+static int is_pow2(int x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Tællere med konfigurerbar bredde og politik
+// ---------------------------------------------------------------------------
+
+int counter_table_init(struct CounterTable *t, int entries, int width, int init,
+                       enum CounterPolicy policy) {
+    memset(t, 0, sizeof *t);
+    if (width < 1 || width > MAX_COUNTER_BITS || policy < 0 || policy >= NUM_COUNTER_POLICIES ||
+        !is_pow2(entries) || init < 0 || init >= (1 << width))
+        return -1;
+    t->entries = entries;
+    t->width = width;
+    t->init = init;
+    t->policy = policy;
+    t->lfsr = 0xACE1u;
+    t->table = malloc(entries);
+    if (!t->table)
+        return -1;
+    memset(t->table, init, entries);
+    return 0;
+}
+
+void counter_table_free(struct CounterTable *t) {
+    free(t->table);
+    t->table = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// TAGE
+// ---------------------------------------------------------------------------
+
+// Geometriske historielængder (ratio ca. 2.3) for de tagged tabeller
+static const int tage_hist_lengths[NUM_TAGE_TABLES] = {5, 12, 27, 64};
+
+// Halverer useful bits periodisk så gamle entries kan erstattes
+#define TAGE_U_RESET_PERIOD (1 << 18)
+
+static void fold_init(struct FoldedHist *f, int i, int orig_len, int comp_len) {
+    f->comp[i] = 0;
+    f->outbit[i] = 1u << (orig_len % comp_len);
+    f->topbit[i] = 1u << comp_len;
+}
+
+// Skubber den nyeste historiebit ind i alle tabellers fold og bitten der
+// falder ud af vinduet ud (out er -1 i de lanes hvor den er 1). Koster O(1)
+// uanset historielængde og uden variable shifts.
+static inline void fold_update(struct FoldedHist *f, uint32_t newbit, tage_v4su out) {
+    tage_v4su c = (f->comp << 1) | newbit;
+    c ^= out & f->outbit;
+    c ^= (tage_v4su)((c & f->topbit) != 0) & 1;
+    f->comp = c & (f->topbit - 1);
+}
+
+int tage_init(struct Tage *t, int budget_bits) {
+    memset(t, 0, sizeof *t);
+    t->budget_bits = budget_bits;
+
+    // Tag bredden vokser med budgettet
+    if (budget_bits < 4096)
+        t->tag_bits = 7;
+    else if (budget_bits < 16384)
+        t->tag_bits = 8;
+    else
+        t->tag_bits = 9;
+    int entry_bits = 3 + 2 + t->tag_bits;
+
+    // Ca. 1/4 af budgettet til base (2-bit counters), resten deles ligeligt
+    t->log_base = floor_log2(budget_bits / 4 / 2);
+    int base_bits = 2 << t->log_base;
+    t->log_entries = floor_log2((budget_bits - base_bits) / NUM_TAGE_TABLES / entry_bits);
+    if (t->log_base < 1 || t->log_entries < 1)
+        return -1;
+
+    int used = base_bits + NUM_TAGE_TABLES * (1 << t->log_entries) * entry_bits;
+    // Overskud fra afrundingen giver vi tilbage til base
+    while (used + (2 << t->log_base) <= budget_bits) {
+        used += 2 << t->log_base;
+        t->log_base++;
+    }
+    t->used_bits = used;
+
+    t->base = malloc(1u << t->log_base);
+    if (!t->base)
+        return -1;
+    for (int j = 0; j < (1 << t->log_base); j++)
+        t->base[j] = 1;     // svagt ikke taget, som bimodal
+
+    for (int i = 0; i < NUM_TAGE_TABLES; i++) {
+        t->tables[i] = calloc(1u << t->log_entries, sizeof(struct TageEntry));
+        if (!t->tables[i])
+            return -1;
+        t->hist_len[i] = tage_hist_lengths[i];
+        fold_init(&t->idx_fold, i, t->hist_len[i], t->log_entries);
+        fold_init(&t->tag_fold0, i, t->hist_len[i], t->tag_bits);
+        fold_init(&t->tag_fold1, i, t->hist_len[i], t->tag_bits - 1);
+        uint64_t old = 1ull << (t->hist_len[i] - 1);
+        t->old_lo[i] = (uint32_t)old;
+        t->old_hi[i] = (uint32_t)(old >> 32);
+    }
+
+    t->lfsr = 0xACE1u;
+    return 0;
+}
+
+void tage_free(struct Tage *t) {
+    free(t->base);
+    t->base = NULL;
+    for (int i = 0; i < NUM_TAGE_TABLES; i++) {
+        free(t->tables[i]);
+        t->tables[i] = NULL;
+    }
+}
+
+// Index og tag for alle tabeller regnes på én gang ud fra folded registers,
+// og gemmes til tage_update.
+int tage_predict(struct Tage *t, uint32_t pc) {
+    uint32_t pc_index = pc >> 2;
+    uint32_t mask = (1u << t->log_entries) - 1;
+    uint32_t tag_mask = (1u << t->tag_bits) - 1;
+
+    t->idx = (pc_index ^ (pc_index >> t->log_entries) ^ t->idx_fold.comp) & mask;
+    t->tag = (pc_index ^ t->tag_fold0.comp ^ (t->tag_fold1.comp << 1)) & tag_mask;
+
+    t->provider = -1;
+    t->alt_provider = -1;
+    for (int i = NUM_TAGE_TABLES - 1; i >= 0; i--) {
+        if (t->tables[i][t->idx[i]].tag == t->tag[i]) {
+            if (t->provider < 0) {
+                t->provider = i;
+            } else {
+                t->alt_provider = i;
+                break;
+            }
+        }
+    }
+
+    int base_pred = (t->base[pc_index & ((1u << t->log_base) - 1)] >> 1) & 1;
+    if (t->alt_provider >= 0)
+        t->alt_pred = t->tables[t->alt_provider][t->idx[t->alt_provider]].ctr >= 0;
+    else
+        t->alt_pred = base_pred;
+
+    t->newly_alloc = 0;
+    if (t->provider >= 0) {
+        struct TageEntry *e = &t->tables[t->provider][t->idx[t->provider]];
+        t->provider_pred = e->ctr >= 0;
+        t->newly_alloc = (e->ctr == 0 || e->ctr == -1) && e->u == 0;
+        if (t->newly_alloc && t->use_alt_on_na >= 0)
+            t->pred = t->alt_pred;
+        else
+            t->pred = t->provider_pred;
+    } else {
+        t->provider_pred = base_pred;
+        t->pred = base_pred;
+    }
+    return t->pred;
+}
+
+static inline int8_t ctr3_update(int8_t c, int taken) {
+    if (taken) {
+        if (c < 3) c++;
+    } else {
+        if (c > -4) c--;
+    }
+    return c;
+}
+
+// Kræver at tage_predict er kaldt for samme pc lige forinden
+void tage_update(struct Tage *t, uint32_t pc, int taken) {
+    uint32_t pc_index = pc >> 2;
+
+    if (t->newly_alloc && t->provider_pred != t->alt_pred) {
+        if (t->alt_pred == taken) {
+            if (t->use_alt_on_na < 7) t->use_alt_on_na++;
+        } else {
+            if (t->use_alt_on_na > -8) t->use_alt_on_na--;
+        }
+    }
+
+    // Allokering ved misprediction i en tabel med længere historie
+    if (t->pred != taken && t->provider < NUM_TAGE_TABLES - 1) {
+        int start = t->provider + 1;
+        // Spring af og til den første kandidat over for at sprede allokeringer
+        if ((lfsr_next(&t->lfsr) & 1) && start < NUM_TAGE_TABLES - 1)
+            start++;
+
+        int alloc = -1;
+        for (int i = start; i < NUM_TAGE_TABLES; i++) {
+            if (t->tables[i][t->idx[i]].u == 0) {
+                alloc = i;
+                break;
+            }
+        }
+        if (alloc < 0 && start > t->provider + 1 && t->tables[t->provider + 1][t->idx[t->provider + 1]].u == 0)
+            alloc = t->provider + 1;
+
+        if (alloc >= 0) {
+            struct TageEntry *n = &t->tables[alloc][t->idx[alloc]];
+            n->tag = t->tag[alloc];
+            n->ctr = taken ? 0 : -1;
+            n->u = 0;
+        } else {
+            for (int i = t->provider + 1; i < NUM_TAGE_TABLES; i++) {
+                if (t->tables[i][t->idx[i]].u > 0)
+                    t->tables[i][t->idx[i]].u--;
+            }
+        }
+    }
+
+    // Opdater provider (eller base)
+    if (t->provider >= 0) {
+        struct TageEntry *e = &t->tables[t->provider][t->idx[t->provider]];
+        e->ctr = ctr3_update(e->ctr, taken);
+        if (t->provider_pred != t->alt_pred) {
+            if (t->provider_pred == taken) {
+                if (e->u < 3) e->u++;
+            } else {
+                if (e->u > 0) e->u--;
+            }
+        }
+    } else {
+        uint8_t *c = &t->base[pc_index & ((1u << t->log_base) - 1)];
+        if (taken) {
+            if (*c < 3) (*c)++;
+        } else {
+            if (*c > 0) (*c)--;
+        }
+    }
+
+    // Graceful reset af useful bits
+    if ((++t->branches & (TAGE_U_RESET_PERIOD - 1)) == 0) {
+        for (int i = 0; i < NUM_TAGE_TABLES; i++)
+            for (int j = 0; j < (1 << t->log_entries); j++)
+                t->tables[i][j].u >>= 1;
+    }
+
+    // Opdater global history og folded registers. Bitten der falder ud af
+    // hver tabels vindue er den samme for alle tre folds af tabellen.
+    tage_v4su out = (tage_v4su)(((t->old_lo & (uint32_t)t->ghist) |
+                                 (t->old_hi & (uint32_t)(t->ghist >> 32))) != 0);
+    uint32_t newbit = taken ? 1 : 0;
+    t->ghist = (t->ghist << 1) | newbit;
+    fold_update(&t->idx_fold, newbit, out);
+    fold_update(&t->tag_fold0, newbit, out);
+    fold_update(&t->tag_fold1, newbit, out);
+}
+
+// ---------------------------------------------------------------------------
+// Lokal historie (PAg / PAp)
+// ---------------------------------------------------------------------------
+
+int local_init(struct LocalPred *l, int bht_entries, int hist_bits, int pht_entries) {
+    memset(l, 0, sizeof *l);
+    if (!is_pow2(bht_entries) || !is_pow2(pht_entries) ||
+        hist_bits < 1 || hist_bits > 16 || pht_entries < (1 << hist_bits))
+        return -1;
+
+    l->bht_entries = bht_entries;
+    l->hist_bits = hist_bits;
+    l->pht_entries = pht_entries;
+    l->set_bits = floor_log2(pht_entries) - hist_bits;
+
+    l->bht = calloc(bht_entries, sizeof(uint16_t));
+    l->pht = malloc(pht_entries);
+    if (!l->bht || !l->pht)
+        return -1;
+    for (int j = 0; j < pht_entries; j++)
+        l->pht[j] = 1;      // svagt ikke taget
+    return 0;
+}
+
+void local_free(struct LocalPred *l) {
+    free(l->bht);
+    free(l->pht);
+    l->bht = NULL;
+    l->pht = NULL;
+}
+
+int local_predict(struct LocalPred *l, uint32_t pc) {
+    uint32_t pc_index = pc >> 2;
+    l->bht_idx = pc_index & (l->bht_entries - 1);
+    uint32_t set = pc_index & ((1u << l->set_bits) - 1);
+    l->pht_idx = (set << l->hist_bits) | l->bht[l->bht_idx];
+    return (l->pht[l->pht_idx] >> 1) & 1;
+}
+
+// Kræver at local_predict er kaldt lige forinden
+void local_update(struct LocalPred *l, int taken) {
+    uint8_t *c = &l->pht[l->pht_idx];
+    if (taken) {
+        if (*c < 3) (*c)++;
+    } else {
+        if (*c > 0) (*c)--;
+    }
+    uint16_t *h = &l->bht[l->bht_idx];
+    *h = (uint16_t)(((*h << 1) | (taken ? 1u : 0u)) & ((1u << l->hist_bits) - 1));
+}
+
+// ---------------------------------------------------------------------------
+// BTB
+// ---------------------------------------------------------------------------
+
+int btb_init(struct Btb *b, int sets, int ways, int tag_bits) {
+    memset(b, 0, sizeof *b);
+    if (!is_pow2(sets) || ways < 1 || tag_bits < 0 || tag_bits > 30)
+        return -1;
+    b->sets = sets;
+    b->ways = ways;
+    b->tag_bits = tag_bits;
+    b->log_sets = floor_log2(sets);
+    b->entries = calloc((size_t)sets * ways, sizeof(struct BtbEntry));
+    return b->entries ? 0 : -1;
+}
+
+void btb_free(struct Btb *b) {
+    free(b->entries);
+    b->entries = NULL;
+}
+
+static inline uint32_t btb_tag(const struct Btb *b, uint32_t pc) {
+    uint32_t tag = (pc >> 2) >> b->log_sets;
+    if (b->tag_bits)
+        tag &= (1u << b->tag_bits) - 1;
+    return tag;
+}
+
+int btb_lookup(struct Btb *b, uint32_t pc, uint32_t *target) {
+    struct BtbEntry *set = &b->entries[((pc >> 2) & (b->sets - 1)) * b->ways];
+    uint32_t tag = btb_tag(b, pc);
+    for (int w = 0; w < b->ways; w++) {
+        if (set[w].valid && set[w].tag == tag) {
+            set[w].lru = ++b->tick;
+            *target = set[w].target;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void btb_update(struct Btb *b, uint32_t pc, uint32_t target) {
+    struct BtbEntry *set = &b->entries[((pc >> 2) & (b->sets - 1)) * b->ways];
+    uint32_t tag = btb_tag(b, pc);
+    struct BtbEntry *victim = &set[0];
+    for (int w = 0; w < b->ways; w++) {
+        if (set[w].valid && set[w].tag == tag) {
+            victim = &set[w];
+            break;
+        }
+        // tomme entries foretrækkes, ellers LRU
+        if (!set[w].valid) {
+            if (victim->valid)
+                victim = &set[w];
+        } else if (victim->valid && set[w].lru < victim->lru) {
+            victim = &set[w];
+        }
+    }
+    victim->valid = 1;
+    victim->tag = tag;
+    victim->target = target;
+    victim->lru = ++b->tick;
+}
+
+// ---------------------------------------------------------------------------
+// RAS
+// ---------------------------------------------------------------------------
+
+int ras_init(struct Ras *r, int depth, enum RasOverflow policy) {
+    memset(r, 0, sizeof *r);
+    if (depth < 1)
+        return -1;
+    r->depth = depth;
+    r->policy = policy;
+    r->stack = calloc(depth, sizeof(uint32_t));
+    return r->stack ? 0 : -1;
+}
+
+void ras_free(struct Ras *r) {
+    free(r->stack);
+    r->stack = NULL;
+}
+
+void ras_push(struct Ras *r, uint32_t addr) {
+    if (r->count == r->depth) {
+        r->overflows++;
+        if (r->policy == RAS_OVERFLOW_DROP)
+            return;
+        r->count--;     // ældste overskrives
+    }
+    r->stack[r->top] = addr;
+    r->top = (r->top + 1) % r->depth;
+    r->count++;
+}
+
+int ras_pop(struct Ras *r, uint32_t *addr) {
+    if (r->count == 0) {
+        r->underflows++;
+        return 0;
+    }
+    r->top = (r->top + r->depth - 1) % r->depth;
+    r->count--;
+    *addr = r->stack[r->top];
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Indirekte target cache
+// ---------------------------------------------------------------------------
+
+int tc_init(struct TargetCache *tc, int entries, int hist_bits) {
+    memset(tc, 0, sizeof *tc);
+    if (!is_pow2(entries) || hist_bits < 0 || hist_bits > 31)
+        return -1;
+    tc->log_entries = floor_log2(entries);
+    tc->hist_bits = hist_bits;
+    tc->entries = calloc(entries, sizeof(struct TcEntry));
+    return tc->entries ? 0 : -1;
+}
+
+void tc_free(struct TargetCache *tc) {
+    free(tc->entries);
+    tc->entries = NULL;
+}
+
+int tc_predict(struct TargetCache *tc, uint32_t pc, uint32_t *target) {
+    uint32_t pc_index = pc >> 2;
+    tc->idx = (pc_index ^ tc->path) & ((1u << tc->log_entries) - 1);
+    tc->tag = pc_index;
+    struct TcEntry *e = &tc->entries[tc->idx];
+    if (e->valid && e->tag == tc->tag) {
+        *target = e->target;
+        return 1;
+    }
+    return 0;
+}
+
+void tc_update(struct TargetCache *tc, uint32_t target) {
+    struct TcEntry *e = &tc->entries[tc->idx];
+    if (!e->valid || e->tag != tc->tag) {
+        e->valid = 1;
+        e->tag = tc->tag;
+        e->target = target;
+        e->conf = 1;
+    } else if (e->target == target) {
+        if (e->conf < 3) e->conf++;
+    } else if (e->conf > 0) {
+        e->conf--;
+    } else {
+        e->target = target;
+        e->conf = 1;
+    }
+}
+
+void tc_path_update(struct TargetCache *tc, uint32_t target) {
+    tc->path = ((tc->path << 2) ^ (target >> 2)) & ((1u << tc->hist_bits) - 1);
+}
+
+// ---------------------------------------------------------------------------
+// Loop predictor
+// ---------------------------------------------------------------------------
+
+#define LOOP_AGE_INIT 31
+#define LOOP_ITER_MAX 0xFFFF
+
+int loop_init(struct LoopPred *l, int entries) {
+    memset(l, 0, sizeof *l);
+    if (!is_pow2(entries))
+        return -1;
+    l->log_entries = floor_log2(entries);
+    l->entries = calloc(entries, sizeof(struct LoopEntry));
+    return l->entries ? 0 : -1;
+}
+
+void loop_free(struct LoopPred *l) {
+    free(l->entries);
+    l->entries = NULL;
+}
+
+int loop_predict(struct LoopPred *l, uint32_t pc, int *pred) {
+    uint32_t pc_index = pc >> 2;
+    l->idx = pc_index & ((1u << l->log_entries) - 1);
+    l->tag = (uint16_t)(pc_index >> l->log_entries);
+    struct LoopEntry *e = &l->entries[l->idx];
+    l->hit = (e->age > 0 && e->tag == l->tag) ? e : NULL;
+    l->confident = l->hit && e->conf == LOOP_CONF_MAX;
+    // Taget indtil vi har set past_iter iterationer, så exit
+    l->pred = !(l->hit && e->cur_iter == e->past_iter);
+    *pred = l->pred;
+    return l->confident;
+}
+
+void loop_update(struct LoopPred *l, int taken, int is_backward) {
+    struct LoopEntry *e = l->hit;
+    if (!e) {
+        // Allokér ved et loop exit der ikke følges endnu
+        if (!is_backward || taken)
+            return;
+        e = &l->entries[l->idx];
+        if (e->age > 0) {
+            e->age--;       // en anden loop bor her, den ældes lidt
+            return;
+        }
+        e->tag = l->tag;
+        e->past_iter = 0;
+        e->cur_iter = 0;
+        e->conf = 0;
+        e->age = LOOP_AGE_INIT;
+        return;
+    }
+
+    // Sikker men forkert: trip count er ikke fast, så entry frigives
+    if (l->confident && l->pred != taken) {
+        e->age = 0;
+        e->conf = 0;
+        return;
+    }
+
+    if (taken) {
+        if (++e->cur_iter == LOOP_ITER_MAX) {
+            e->age = 0;     // for lang til at blive fulgt
+            e->conf = 0;
+        }
+        return;
+    }
+
+    // Loop exit
+    if (e->cur_iter == e->past_iter) {
+        if (e->conf < LOOP_CONF_MAX) e->conf++;
+        if (e->age < 255) e->age++;
+    } else {
+        e->past_iter = e->cur_iter;
+        e->conf = 0;
+    }
+    e->cur_iter = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Hashed perceptron
+// ---------------------------------------------------------------------------
+
+#define PERC_WEIGHT_BITS 8
+#define PERC_HASH_MULT   0x9E3779B1u
+
+int perceptron_init(struct Perceptron *p, int budget_bits, int hist_len) {
+    memset(p, 0, sizeof *p);
+    p->budget_bits = budget_bits;
+    p->hist_len = hist_len;
+    p->log_entries = floor_log2(budget_bits / NUM_PERC_TABLES / PERC_WEIGHT_BITS);
+    if (p->log_entries < 1 || hist_len < NUM_PERC_TABLES - 1 || hist_len > 64)
+        return -1;
+    p->used_bits = NUM_PERC_TABLES * (1 << p->log_entries) * PERC_WEIGHT_BITS;
+
+    // Tærskel fra Jiménez & Lin: 1.93 * antal input + 14
+    p->theta = (193 * NUM_PERC_TABLES) / 100 + 14;
+
+    // Tabel 0 er bias (ingen historie), tabel k bruger de seneste hist_len*k/(N-1) bits
+    for (int k = 0; k < NUM_PERC_TABLES; k++) {
+        int len = hist_len * k / (NUM_PERC_TABLES - 1);
+        uint64_t m = len >= 64 ? ~0ull : (1ull << len) - 1;
+        p->seg_lo[k] = (uint32_t)m;
+        p->seg_hi[k] = (uint32_t)(m >> 32);
+    }
+
+    p->weights = calloc((size_t)NUM_PERC_TABLES << p->log_entries, 1);
+    if (!p->weights)
+        return -1;
+    return 0;
+}
+
+void perceptron_free(struct Perceptron *p) {
+    free(p->weights);
+    p->weights = NULL;
+}
+
+// Hashen regnes på alle 8 tabeller på én gang med GCC vector extensions; de
+// 64 historiebits foldes som to 32-bit halvdele, så der ikke skal regnes i
+// 64-bit lanes. Vægtene læses og summeres i samme skalare løkke: at samle dem
+// i en vektor først koster en omvej over stakken uden -march.
+int perceptron_predict(struct Perceptron *p, uint32_t pc) {
+    static const perc_v8su lane = {0, 1, 2, 3, 4, 5, 6, 7};
+    perc_v8su h = (p->seg_lo & (uint32_t)p->ghist) ^ (p->seg_hi & (uint32_t)(p->ghist >> 32));
+    h = (h ^ (pc >> 2) ^ (lane << 24)) * PERC_HASH_MULT;
+    h = (h >> (32 - p->log_entries)) + (lane << p->log_entries);
+    p->idx = (perc_v8si)h;
+
+    int sum = 0;
+    for (int k = 0; k < NUM_PERC_TABLES; k++)
+        sum += p->weights[h[k]];
+    p->sum = sum;
+    p->pred = sum >= 0;
+    return p->pred;
+}
+
+// Kræver at perceptron_predict er kaldt lige forinden. Mætningen regnes uden
+// hop, de fejlforudsiges ofte i værten.
+void perceptron_update(struct Perceptron *p, int taken) {
+    int mag = p->sum < 0 ? -p->sum : p->sum;
+    if (p->pred != taken || mag <= p->theta) {
+        int8_t lim = taken ? 127 : -128;
+        int8_t step = taken ? 1 : -1;
+        for (int k = 0; k < NUM_PERC_TABLES; k++) {
+            int8_t *w = &p->weights[p->idx[k]];
+            *w += (*w != lim) ? step : 0;
+        }
+    }
+    p->ghist = (p->ghist << 1) | (taken ? 1u : 0u);
+}
@@ -0,0 +1,254 @@
+#ifndef __PREDICTORS_H__
+#define __PREDICTORS_H__
+
+#include <stdint.h>
+#include "counters.h"
+
+// Avancerede branch predictors. Bimodal og gShare ligger direkte i simulate.c,
+// de større predictors herunder har egen tilstand og init/predict/update.
+
+// Tabel af tællere med konfigurerbar bredde, starttilstand og politik.
+// Indeks beregnes af kalderen (bimodal/gShare), som også kalder den
+// ctrW_step_* funktion der passer til width og policy.
+struct CounterTable {
+    int entries;
+    int width;
+    int init;
+    enum CounterPolicy policy;
+    uint32_t lfsr;
+    uint8_t *table;
+};
+
+// returnerer 0 ved succes, -1 ved ugyldig bredde/politik/starttilstand
+int counter_table_init(struct CounterTable *t, int entries, int width, int init,
+                       enum CounterPolicy policy);
+void counter_table_free(struct CounterTable *t);
+// step er en af ctrW_step_*, kaldt direkte med konstant bredde og politik
+#define COUNTER_TABLE_STEP(t, step, idx, taken) \
+    step(&(t)->table[(idx) & ((t)->entries - 1)], taken, &(t)->lfsr)
+
+// TAGE: bimodal base + NUM_TAGE_TABLES tagged tabeller med geometriske
+// historielængder. Konfigureres med et samlet storage budget i bits.
+#define NUM_TAGE_TABLES 4
+
+typedef uint32_t tage_v4su __attribute__((vector_size(NUM_TAGE_TABLES * sizeof(uint32_t))));
+
+// Folded history for alle tabeller på én gang, lane i er tabel i: komprimerer
+// de seneste hist_len[i] historiebits til comp_len bits
+struct FoldedHist {
+    tage_v4su comp;
+    tage_v4su outbit;   // 1 << (hist_len % comp_len), hvor den udfaldne bit lander
+    tage_v4su topbit;   // 1 << comp_len, den bit der roteres rundt til bit 0
+};
+
+struct TageEntry {
+    uint16_t tag;
+    int8_t ctr;     // 3-bit signed counter, -4..3, >= 0 betyder taget
+    uint8_t u;      // 2-bit useful counter
+};
+
+struct Tage {
+    int budget_bits;    // ønsket budget
+    int used_bits;      // faktisk brugt storage
+
+    // base bimodal
+    uint8_t *base;
+    int log_base;
+
+    // tagged tabeller
+    struct TageEntry *tables[NUM_TAGE_TABLES];
+    int log_entries;
+    int tag_bits;
+    int hist_len[NUM_TAGE_TABLES];     // max 64
+
+    struct FoldedHist idx_fold;
+    struct FoldedHist tag_fold0;
+    struct FoldedHist tag_fold1;
+
+    // global history, nyeste bit i bit 0. old_lo/old_hi vælger bit
+    // hist_len[i] - 1, den der falder ud af tabel i's vindue ved næste branch.
+    uint64_t ghist;
+    tage_v4su old_lo, old_hi;
+
+    int use_alt_on_na;      // 4-bit signed, >= 0 -> brug altpred på nye entries
+    uint32_t lfsr;          // deterministisk "tilfældighed" til allokering
+    unsigned long long branches;
+
+    // resultat af seneste tage_predict, bruges af tage_update
+    int provider;           // -1 = base
+    int alt_provider;       // -1 = base
+    int provider_pred;
+    int alt_pred;
+    int pred;
+    int newly_alloc;        // provider er en ny entry der ikke er trænet endnu
+    tage_v4su idx;
+    tage_v4su tag;
+};
+
+// returnerer 0 ved succes, -1 hvis budgettet er for lille
+int tage_init(struct Tage *t, int budget_bits);
+void tage_free(struct Tage *t);
+int tage_predict(struct Tage *t, uint32_t pc);
+void tage_update(struct Tage *t, uint32_t pc, int taken);
+
+// To-niveau lokal historie (PAg / PAp): BHT indekseret med PC holder de seneste
+// hist_bits udfald for hver branch, som indekserer en PHT af 2-bit counters.
+// PHT'en er delt i pht_entries >> hist_bits sæt valgt med PC; ét sæt = PAg.
+struct LocalPred {
+    int bht_entries;
+    int hist_bits;
+    int pht_entries;
+    int set_bits;       // log2(antal PHT sæt), 0 for PAg
+
+    uint16_t *bht;
+    uint8_t *pht;
+
+    // fra seneste local_predict
+    uint32_t bht_idx;
+    uint32_t pht_idx;
+};
+
+// returnerer 0 ved succes, -1 ved ugyldig konfiguration (størrelser skal være 2^n,
+// hist_bits <= 16 og pht_entries >= 2^hist_bits)
+int local_init(struct LocalPred *l, int bht_entries, int hist_bits, int pht_entries);
+void local_free(struct LocalPred *l);
+int local_predict(struct LocalPred *l, uint32_t pc);
+void local_update(struct LocalPred *l, int taken);
+
+// Branch target buffer: set-associativ med LRU og partielle tags.
+// tag_bits = 0 betyder fuldt tag (ingen aliasing).
+struct BtbEntry {
+    uint32_t tag;
+    uint32_t target;
+    uint64_t lru;       // tidsstempel for seneste brug
+    uint8_t valid;
+};
+
+struct Btb {
+    int sets;
+    int ways;
+    int tag_bits;
+    int log_sets;
+    struct BtbEntry *entries;   // sets * ways
+    uint64_t tick;      // 64 bit så LRU ikke går galt ved wrap
+};
+
+int btb_init(struct Btb *b, int sets, int ways, int tag_bits);
+void btb_free(struct Btb *b);
+// returnerer 1 og sætter *target ved hit, ellers 0
+int btb_lookup(struct Btb *b, uint32_t pc, uint32_t *target);
+void btb_update(struct Btb *b, uint32_t pc, uint32_t target);
+
+// Return address stack. Ved overflow overskrives enten den ældste
+// adresse (RAS_OVERFLOW_WRAP) eller også droppes det nye push (RAS_OVERFLOW_DROP).
+enum RasOverflow { RAS_OVERFLOW_WRAP, RAS_OVERFLOW_DROP };
+
+struct Ras {
+    int depth;
+    enum RasOverflow policy;
+    uint32_t *stack;
+    int top;            // index for næste push (cirkulært)
+    int count;
+    unsigned long long overflows;
+    unsigned long long underflows;
+};
+
+int ras_init(struct Ras *r, int depth, enum RasOverflow policy);
+void ras_free(struct Ras *r);
+void ras_push(struct Ras *r, uint32_t addr);
+// returnerer 1 og sætter *addr hvis stakken ikke er tom
+int ras_pop(struct Ras *r, uint32_t *addr);
+
+// Indirekte target cache (path history): targets for ikke-return jalr gemmes i en
+// tabel indekseret med PC XOR en historie af de seneste hop-targets.
+struct TcEntry {
+    uint32_t tag;
+    uint32_t target;
+    uint8_t valid;
+    uint8_t conf;       // 2-bit hysterese før target udskiftes
+};
+
+struct TargetCache {
+    int log_entries;
+    int hist_bits;
+    uint32_t path;      // path history
+    struct TcEntry *entries;
+
+    // fra seneste tc_predict
+    uint32_t idx;
+    uint32_t tag;
+};
+
+int tc_init(struct TargetCache *tc, int entries, int hist_bits);
+void tc_free(struct TargetCache *tc);
+// returnerer 1 og sætter *target ved hit, ellers 0
+int tc_predict(struct TargetCache *tc, uint32_t pc, uint32_t *target);
+// Kræver at tc_predict er kaldt for samme pc lige forinden
+void tc_update(struct TargetCache *tc, uint32_t target);
+// Skubber et hop-target ind i path historien
+void tc_path_update(struct TargetCache *tc, uint32_t target);
+
+// Loop predictor: lærer trip count for bagudrettede branches og forudsiger
+// loop exit (ikke taget) når samme antal iterationer er set flere gange i træk.
+#define LOOP_CONF_MAX 7
+
+struct LoopEntry {
+    uint16_t tag;
+    uint16_t past_iter;     // trip count ved seneste exit
+    uint16_t cur_iter;      // tagne iterationer siden seneste exit
+    uint8_t conf;           // antal exits i træk med samme trip count
+    uint8_t age;            // 0 = ledig
+};
+
+struct LoopPred {
+    int log_entries;
+    struct LoopEntry *entries;
+
+    // fra seneste loop_predict
+    struct LoopEntry *hit;
+    uint32_t idx;
+    uint16_t tag;
+    int confident;
+    int pred;
+};
+
+int loop_init(struct LoopPred *l, int entries);
+void loop_free(struct LoopPred *l);
+// Returnerer 1 hvis der er en sikker forudsigelse (sat i *pred), ellers 0
+int loop_predict(struct LoopPred *l, uint32_t pc, int *pred);
+// Kræver at loop_predict er kaldt lige forinden. Kun bagudrettede branches allokeres.
+void loop_update(struct LoopPred *l, int taken, int is_backward);
+
+// Hashed perceptron: NUM_PERC_TABLES vægttabeller. Tabel 0 indekseres kun med
+// PC (bias), tabel k med PC hashet med de seneste hist_len*k/(N-1) historiebits.
+// Prediction er fortegnet af summen af de N vægte.
+#define NUM_PERC_TABLES 8
+
+typedef uint32_t perc_v8su __attribute__((vector_size(8 * sizeof(uint32_t))));
+typedef int32_t  perc_v8si __attribute__((vector_size(8 * sizeof(int32_t))));
+
+struct Perceptron {
+    int budget_bits;
+    int used_bits;
+    int hist_len;       // max 64
+    int log_entries;    // entries per tabel = 2^log_entries
+    int theta;          // træningstærskel
+
+    int8_t *weights;    // NUM_PERC_TABLES tabeller efter hinanden
+    // hvilke historiebits hver tabel hasher med, delt i nederste og øverste 32 bits
+    perc_v8su seg_lo, seg_hi;
+    uint64_t ghist;
+
+    // resultat af seneste perceptron_predict
+    perc_v8si idx;
+    int sum;
+    int pred;
+};
+
+// returnerer 0 ved succes, -1 hvis budget eller historielængde er ugyldig
+int perceptron_init(struct Perceptron *p, int budget_bits, int hist_len);
+void perceptron_free(struct Perceptron *p);
+int perceptron_predict(struct Perceptron *p, uint32_t pc);
+void perceptron_update(struct Perceptron *p, int taken);
+
+#endif
@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include "profile.h"
+
+static const char *prof_pred_names[NUM_PROF_PREDS] = {
+    "BTFNT", "Bimodal", "gShare", "Tourn", "TAGE", "Percep", "Local"
+};
+
+struct BranchProfile *profile_create(uint32_t text_start, uint32_t text_end) {
+    struct BranchProfile *prof = calloc(1, sizeof(struct BranchProfile));
+    if (!prof)
+        return NULL;
+    // text_start kan ligge midt i et word, så der rundes ned
+    prof->text_start = text_start & ~3u;
+    prof->text_end = text_end;
+    prof->enabled = (1u << NUM_PROF_PREDS) - 1;
+    size_t slots = (prof->text_end - prof->text_start + 3) / 4;
+    prof->sites = calloc(slots ? slots : 1, sizeof(struct BranchSite));
+    if (!prof->sites) {
+        free(prof);
+        return NULL;
+    }
+    return prof;
+}
+
+void profile_delete(struct BranchProfile *prof) {
+    if (!prof)
+        return;
+    free(prof->sites);
+    free(prof);
+}
+
+static const char *branch_class_names[NUM_BRANCH_CLASSES] = {
+    "always taken", "never taken", "biased", "loop-like", "random"
+};
+
+enum BranchClass profile_classify(const struct BranchSite *site) {
+    if (site->taken == site->execs)
+        return BRANCH_ALWAYS_TAKEN;
+    if (site->taken == 0)
+        return BRANCH_NEVER_TAKEN;
+    // mindst to perioder og næsten kun gentagne runs
+    if (site->runs >= 4 && 10 * site->repeated_runs >= 9 * site->runs)
+        return BRANCH_LOOP;
+    unsigned long long minority = site->taken < site->execs - site->taken
+                                  ? site->taken : site->execs - site->taken;
+    if (20 * minority <= site->execs)
+        return BRANCH_BIASED;
+    return BRANCH_RANDOM;
+}
+
+void profile_class_stats(const struct BranchProfile *prof,
+                         struct BranchClassStat classes[NUM_BRANCH_CLASSES]) {
+    for (int c = 0; c < NUM_BRANCH_CLASSES; c++)
+        classes[c] = (struct BranchClassStat){0};
+    size_t slots = (prof->text_end - prof->text_start + 3) / 4;
+    for (size_t i = 0; i < slots; i++) {
+        const struct BranchSite *s = &prof->sites[i];
+        if (!s->execs)
+            continue;
+        struct BranchClassStat *cs = &classes[profile_classify(s)];
+        cs->sites++;
+        cs->execs += s->execs;
+        for (int p = 0; p < NUM_PROF_PREDS; p++)
+            cs->mispreds[p] += s->mispreds[p];
+    }
+}
+
+void profile_print_classes(FILE *out, const struct BranchProfile *prof) {
+    struct BranchClassStat classes[NUM_BRANCH_CLASSES];
+    unsigned long long total_execs = 0;
+    unsigned long long total_mispreds[NUM_PROF_PREDS] = {0};
+
+    profile_class_stats(prof, classes);
+    for (int c = 0; c < NUM_BRANCH_CLASSES; c++) {
+        total_execs += classes[c].execs;
+        for (int p = 0; p < NUM_PROF_PREDS; p++)
+            total_mispreds[p] += classes[c].mispreds[p];
+    }
+
+    fprintf(out, "\nBranch classes (mispredictions per class, %% of the predictor's total):\n");
+    fprintf(out, "  %-12s %6s %12s %6s", "class", "sites", "execs", "%");
+    for (int p = 0; p < NUM_PROF_PREDS; p++)
+        if (prof->enabled & (1u << p))
+            fprintf(out, " %17s", prof_pred_names[p]);
+    fprintf(out, "\n");
+    for (int c = 0; c < NUM_BRANCH_CLASSES; c++) {
+        const struct BranchClassStat *cs = &classes[c];
+        fprintf(out, "  %-12s %6d %12llu %5.1f%%", branch_class_names[c], cs->sites, cs->execs,
+                total_execs ? 100.0 * cs->execs / total_execs : 0.0);
+        for (int p = 0; p < NUM_PROF_PREDS; p++)
+            if (prof->enabled & (1u << p))
+                fprintf(out, " %10llu %5.1f%%", cs->mispreds[p],
+                        total_mispreds[p] ? 100.0 * cs->mispreds[p] / total_mispreds[p] : 0.0);
+        fprintf(out, "\n");
+    }
+}
+
+// qsort har ingen kontekst parameter, så sorteringsnøglen gemmes her
+static enum ProfPred sort_key;
+
+static int cmp_sites(const void *a, const void *b) {
+    const struct BranchSite *sa = *(const struct BranchSite * const *)a;
+    const struct BranchSite *sb = *(const struct BranchSite * const *)b;
+    unsigned long long ma = sa->mispreds[sort_key], mb = sb->mispreds[sort_key];
+    if (ma != mb)
+        return ma < mb ? 1 : -1;
+    if (sa->execs != sb->execs)
+        return sa->execs < sb->execs ? 1 : -1;
+    return sa < sb ? -1 : 1;
+}
+
+int profile_print(FILE *out, const struct BranchProfile *prof, struct symbols *symbols,
+                  int top_n, enum ProfPred sort_by) {
+    size_t slots = (prof->text_end - prof->text_start + 3) / 4;
+    const struct BranchSite **order = malloc((slots ? slots : 1) * sizeof *order);
+    if (!order)
+        return -1;
+    int n = 0;
+    for (size_t i = 0; i < slots; i++)
+        if (prof->sites[i].execs)
+            order[n++] = &prof->sites[i];
+
+    sort_key = sort_by;
+    qsort(order, n, sizeof *order, cmp_sites);
+
+    fprintf(out, "Branch profile: %d static branches, top %d by %s mispredictions\n",
+            n, top_n < n ? top_n : n, prof_pred_names[sort_by]);
+    fprintf(out, "%-8s  %-28s %12s %7s", "pc", "function", "execs", "taken%");
+    for (int p = 0; p < NUM_PROF_PREDS; p++)
+        if (prof->enabled & (1u << p))
+            fprintf(out, " %10s", prof_pred_names[p]);
+    fprintf(out, "\n");
+
+    for (int i = 0; i < n && i < top_n; i++) {
+        const struct BranchSite *s = order[i];
+        uint32_t pc = prof->text_start + 4 * (uint32_t)(s - prof->sites);
+        char where[64];
+        unsigned int offset = 0;
+        const char *func = symbols ? symbols_addr_to_func(symbols, pc, &offset) : NULL;
+        if (func)
+            snprintf(where, sizeof where, "%s+0x%x", func, offset);
+        else
+            snprintf(where, sizeof where, "?");
+        fprintf(out, "%08x  %-28s %12llu %6.1f%%", pc, where, s->execs,
+                100.0 * s->taken / s->execs);
+        for (int p = 0; p < NUM_PROF_PREDS; p++)
+            if (prof->enabled & (1u << p))
+                fprintf(out, " %10llu", s->mispreds[p]);
+        fprintf(out, "\n");
+    }
+    if (prof->outside_text)
+        fprintf(out, "(%llu branches outside the text segment were not profiled)\n",
+                prof->outside_text);
+    free(order);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include "read_elf.h"
+
+// Per-branch profil: for hver betinget branch i text segmentet tælles
+// udførsler, taget og mispredictions for hver profileret predictor.
+
+// Predictors der profileres (største konfiguration af hver slags)
+enum ProfPred {
+    PROF_BTFNT,
+    PROF_BIMODAL,
+    PROF_GSHARE,
+    PROF_TOURNAMENT,
+    PROF_TAGE,
+    PROF_PERCEPTRON,
+    PROF_LOCAL,
+    NUM_PROF_PREDS
+};
+
+// Opførsel af en statisk branch, afgjort ud fra udfaldene når kørslen er slut
+enum BranchClass {
+    BRANCH_ALWAYS_TAKEN,
+    BRANCH_NEVER_TAKEN,
+    BRANCH_BIASED,      // mindst 95% samme udfald
+    BRANCH_LOOP,        // periodisk: samme runlængder gentager sig
+    BRANCH_RANDOM,      // resten, typisk dataafhængig
+    NUM_BRANCH_CLASSES
+};
+
+struct BranchSite {
+    unsigned long long execs;
+    unsigned long long taken;
+    unsigned long long mispreds[NUM_PROF_PREDS];
+
+    // runs af samme udfald: en run der er lige så lang som forrige run med
+    // samme udfald tæller som gentaget (T^n N mønster giver kun gentagne runs)
+    unsigned long long runs;
+    unsigned long long repeated_runs;
+    uint32_t cur_run;
+    uint32_t last_run[2];   // længde af seneste afsluttede run, per udfald
+    uint8_t last_taken;
+};
+
+// Tabellen har én plads per instruktion i text segmentet, så pc'en
+// er sin egen perfekte hash
+struct BranchProfile {
+    uint32_t text_start;
+    uint32_t text_end;
+    struct BranchSite *sites;
+    unsigned enabled;           // bit per ProfPred der kører, sættes af simulate
+    unsigned long long outside_text;   // branches udenfor text segmentet
+};
+
+// NULL hvis der ikke er hukommelse til en site per word i text segmentet
+struct BranchProfile *profile_create(uint32_t text_start, uint32_t text_end);
+void profile_delete(struct BranchProfile *prof);
+
+// NULL hvis pc ligger udenfor text segmentet
+static inline struct BranchSite *profile_site(struct BranchProfile *prof, uint32_t pc) {
+    if (pc < prof->text_start || pc >= prof->text_end) {
+        prof->outside_text++;
+        return NULL;
+    }
+    return &prof->sites[(pc - prof->text_start) >> 2];
+}
+
+static inline void profile_record(struct BranchSite *site, int taken, const uint8_t *wrong) {
+    if (site->execs && taken != site->last_taken) {
+        int t = site->last_taken;
+        site->runs++;
+        if (site->cur_run == site->last_run[t])
+            site->repeated_runs++;
+        site->last_run[t] = site->cur_run;
+        site->cur_run = 0;
+    }
+    site->last_taken = taken;
+    site->cur_run++;
+    site->execs++;
+    site->taken += taken;
+    for (int p = 0; p < NUM_PROF_PREDS; p++)
+        site->mispreds[p] += wrong[p];
+}
+
+enum BranchClass profile_classify(const struct BranchSite *site);
+
+// Statiske og dynamiske branches samt mispredictions per predictor for én klasse
+struct BranchClassStat {
+    int sites;
+    unsigned long long execs;
+    unsigned long long mispreds[NUM_PROF_PREDS];
+};
+
+void profile_class_stats(const struct BranchProfile *prof,
+                         struct BranchClassStat classes[NUM_BRANCH_CLASSES]);
+
+// Skriver dynamiske branches og mispredictions per klasse for hver predictor
+void profile_print_classes(FILE *out, const struct BranchProfile *prof);
+
+// Skriver de top_n branches med flest mispredictions for sort_by.
+// Returnerer -1 hvis der ikke var hukommelse til at sortere dem.
+int profile_print(FILE *out, const struct BranchProfile *prof, struct symbols *symbols,
+                  int top_n, enum ProfPred sort_by);
+
+#endif
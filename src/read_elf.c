@@ -219,6 +219,54 @@ const char* symbols_value_to_sym(struct symbols* symbols, unsigned int value)
     return NULL;
 }
 
+const char* symbols_addr_to_func(struct symbols* symbols, unsigned int addr, unsigned int* offset)
+{
+    // Prefer a function whose [value, value+size) covers addr, otherwise
+    // fall back to the closest function symbol below addr
+    int best = -1;
+    for (int i = 0; i < symbols->num_symbols; i++) {
+        Elf32_Sym* sym = &symbols->symbols[i];
+        if (ELF32_ST_TYPE(sym->st_info) != STT_FUNC || sym->st_value > addr)
+            continue;
+        if (addr < sym->st_value + sym->st_size) {
+            best = i;
+            break;
+        }
+        if (best < 0 || sym->st_value > symbols->symbols[best].st_value)
+            best = i;
+    }
+    if (best < 0)
+        return NULL;
+    *offset = addr - symbols->symbols[best].st_value;
+    return &symbols->strtab[symbols->symbols[best].st_name];
+}
+
+int symbols_func_range(struct symbols* symbols, const char* name, unsigned int* start, unsigned int* end)
+{
+    for (int i = 0; i < symbols->num_symbols; i++) {
+        Elf32_Sym* sym = &symbols->symbols[i];
+        if (ELF32_ST_TYPE(sym->st_info) != STT_FUNC || strcmp(&symbols->strtab[sym->st_name], name))
+            continue;
+        *start = sym->st_value;
+        *end = sym->st_value + sym->st_size;
+        if (sym->st_size == 0) {
+            // no size: the function ends where the next one starts
+            *end = *start + 4;
+            unsigned int next = 0;
+            for (int j = 0; j < symbols->num_symbols; j++) {
+                Elf32_Sym* other = &symbols->symbols[j];
+                if (ELF32_ST_TYPE(other->st_info) == STT_FUNC && other->st_value > *start &&
+                    (next == 0 || other->st_value < next))
+                    next = other->st_value;
+            }
+            if (next)
+                *end = next;
+        }
+        return 0;
+    }
+    return -1;
+}
+
 void symbols_delete(struct symbols* symbols)
 {
     free(symbols->strtab);
@@ -27,5 +27,12 @@ void symbols_delete(struct symbols* symbols);
 // map a value to a symbol (return NULL if no matching symbol found)
 const char* symbols_value_to_sym(struct symbols* symbols, unsigned int value);
 
+// map an address to the function containing it (return NULL if none found).
+// *offset is set to the distance from the start of the function.
+const char* symbols_addr_to_func(struct symbols* symbols, unsigned int addr, unsigned int* offset);
+
+// find the address range [*start, *end) of the named function. Returns 0 on
+// success, -1 if there is no such function symbol.
+int symbols_func_range(struct symbols* symbols, const char* name, unsigned int* start, unsigned int* end);
 
 #endif
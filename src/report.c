@@ -0,0 +1,439 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "report.h"
+#include "profile.h"
+#include "hosttime.h"
+#include "costmodel.h"
+
+#define REPORT_MAX_DEPTH 8
+#define REPORT_KEY_MAX 48
+
+// Fælles udskrivning for JSON og CSV: JSON holder styr på kommaer,
+// CSV på stien til det aktuelle objekt
+struct Report {
+    FILE *out;
+    enum ReportFormat format;
+    int depth;
+    int first[REPORT_MAX_DEPTH];
+    char path[REPORT_MAX_DEPTH][REPORT_KEY_MAX];
+    const struct CostModel *cost;
+    const struct Stat *stats;
+};
+
+static void put_string(struct Report *r, const char *s) {
+    int json = r->format == REPORT_JSON;
+    fputc('"', r->out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (json && (c == '"' || c == '\\'))
+            fprintf(r->out, "\\%c", c);
+        else if (json && c < 0x20)
+            fprintf(r->out, "\\u%04x", c);
+        else if (!json && c == '"')
+            fputs("\"\"", r->out);
+        else
+            fputc(c, r->out);
+    }
+    fputc('"', r->out);
+}
+
+// Starter et felt: JSON skriver komma og nøgle, CSV hele stien.
+// depth 0 er rodobjektet.
+static void key(struct Report *r, const char *name) {
+    if (r->format == REPORT_JSON) {
+        fprintf(r->out, "%s\n%*s", r->first[r->depth] ? "" : ",", 2 * (r->depth + 1), "");
+        r->first[r->depth] = 0;
+        put_string(r, name);
+        fputs(": ", r->out);
+    } else {
+        for (int d = 1; d <= r->depth; d++)
+            fprintf(r->out, "%s.", r->path[d]);
+        fprintf(r->out, "%s,", name);
+    }
+}
+
+static void begin(struct Report *r, const char *name) {
+    if (r->format == REPORT_JSON) {
+        key(r, name);
+        fputc('{', r->out);
+    }
+    r->depth++;
+    r->first[r->depth] = 1;
+    snprintf(r->path[r->depth], REPORT_KEY_MAX, "%s", name);
+}
+
+static void beginf(struct Report *r, const char *fmt, int v) {
+    char name[REPORT_KEY_MAX];
+    snprintf(name, sizeof name, fmt, v);
+    begin(r, name);
+}
+
+static void end(struct Report *r) {
+    r->depth--;
+    if (r->format == REPORT_JSON)
+        fprintf(r->out, "\n%*s}", 2 * (r->depth + 1), "");
+}
+
+static void u64(struct Report *r, const char *name, unsigned long long v) {
+    key(r, name);
+    fprintf(r->out, "%llu%s", v, r->format == REPORT_CSV ? "\n" : "");
+}
+
+static void i64(struct Report *r, const char *name, long long v) {
+    key(r, name);
+    fprintf(r->out, "%lld%s", v, r->format == REPORT_CSV ? "\n" : "");
+}
+
+// inf/nan (fx MIPS for en kørsel under én tick) findes ikke i JSON
+static void f64(struct Report *r, const char *name, double v) {
+    key(r, name);
+    if (isfinite(v))
+        fprintf(r->out, "%.6g", v);
+    else if (r->format == REPORT_JSON)
+        fputs("null", r->out);
+    if (r->format == REPORT_CSV)
+        fputc('\n', r->out);
+}
+
+static void str(struct Report *r, const char *name, const char *v) {
+    key(r, name);
+    put_string(r, v);
+    if (r->format == REPORT_CSV)
+        fputc('\n', r->out);
+}
+
+static void pred_fields(struct Report *r, const struct PredictorStat *p) {
+    u64(r, "predictions", p->predictions);
+    u64(r, "mispredictions", p->mispredictions);
+}
+
+// Cyklusmodellen for en predictor, som i opsummeringen
+static void cost_fields(struct Report *r, const struct PredictorStat *p) {
+    struct Cost c = cost_of(r->cost, r->stats, p);
+    u64(r, "cycles", c.cycles);
+    f64(r, "cpi", c.cpi);
+    f64(r, "speedup", c.speedup);
+}
+
+static void pred(struct Report *r, const char *name, const struct PredictorStat *p) {
+    begin(r, name);
+    pred_fields(r, p);
+    end(r);
+}
+
+static void pred_cost(struct Report *r, const char *name, const struct PredictorStat *p) {
+    begin(r, name);
+    pred_fields(r, p);
+    cost_fields(r, p);
+    end(r);
+}
+
+// Én predictor per størrelse, med størrelsen som nøgle
+static void pred_sizes(struct Report *r, const char *name, const struct PredictorStat *p,
+                       const int *sizes, int with_cost) {
+    begin(r, name);
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        beginf(r, "%d", sizes[i]);
+        pred_fields(r, &p[i]);
+        if (with_cost)
+            cost_fields(r, &p[i]);
+        end(r);
+    }
+    end(r);
+}
+
+static void alias_sizes(struct Report *r, const char *name, const struct AliasStat *as,
+                        const int *sizes) {
+    begin(r, name);
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        const struct AliasStat *a = &as[i];
+        beginf(r, "%d", sizes[i]);
+        u64(r, "accesses", a->accesses);
+        u64(r, "aliased", a->aliased);
+        u64(r, "destructive", a->destructive);
+        u64(r, "constructive", a->constructive);
+        u64(r, "unpredictable", a->unpredictable);
+        u64(r, "keys", a->keys);
+        i64(r, "entries_used", a->entries_used);
+        i64(r, "entries_shared", a->entries_shared);
+        i64(r, "max_sharing", a->max_sharing);
+        end(r);
+    }
+    end(r);
+}
+
+static void write_predictors(struct Report *r, const struct Stat *stats, const int *sizes) {
+    static const char *policy_names[] = {"saturating", "hysteresis", "probabilistic"};
+
+    begin(r, "predictors");
+    pred_cost(r, "nt", &stats->nt);
+    pred_cost(r, "btfnt", &stats->btfnt);
+    pred_sizes(r, "bimodal", stats->bimodal, sizes, 1);
+
+    begin(r, "gshare");
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        beginf(r, "%d", sizes[i]);
+        pred_fields(r, &stats->gshare[i]);
+        cost_fields(r, &stats->gshare[i]);
+        i64(r, "history", stats->gshare_hist[i]);
+        end(r);
+    }
+    end(r);
+
+    if (stats->tournament_enabled) {
+        begin(r, "tournament");
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            const struct TournamentStat *ts = &stats->tournament[i];
+            beginf(r, "%d", sizes[i]);
+            pred_fields(r, &ts->pred);
+            cost_fields(r, &ts->pred);
+            u64(r, "chose_bimodal", ts->chose_bimodal);
+            u64(r, "bimodal_correct", ts->bimodal_correct);
+            u64(r, "chose_gshare", ts->chose_gshare);
+            u64(r, "gshare_correct", ts->gshare_correct);
+            end(r);
+        }
+        end(r);
+    }
+
+    if (stats->tage_enabled) {
+        begin(r, "tage");
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            beginf(r, "%d", sizes[i]);
+            pred_fields(r, &stats->tage[i]);
+            cost_fields(r, &stats->tage[i]);
+            i64(r, "bits", stats->tage_bits[i]);
+            end(r);
+        }
+        end(r);
+    }
+
+    if (stats->perceptron_enabled) {
+        begin(r, "perceptron");
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            beginf(r, "%d", sizes[i]);
+            pred_fields(r, &stats->perceptron[i]);
+            cost_fields(r, &stats->perceptron[i]);
+            i64(r, "bits", stats->perceptron_bits[i]);
+            i64(r, "history", stats->perceptron_hist[i]);
+            end(r);
+        }
+        end(r);
+    }
+
+    if (stats->local_enabled) {
+        begin(r, "local");
+        for (int i = 0; i < stats->num_local; i++) {
+            const struct LocalStat *ls = &stats->local[i];
+            char name[REPORT_KEY_MAX];
+            snprintf(name, sizeof name, "%s_%d_%d_%d",
+                     ls->pht_entries == (1 << ls->hist_bits) ? "pag" : "pap",
+                     ls->bht_entries, ls->hist_bits, ls->pht_entries);
+            begin(r, name);
+            pred_fields(r, &ls->pred);
+            cost_fields(r, &ls->pred);
+            i64(r, "bht_entries", ls->bht_entries);
+            i64(r, "hist_bits", ls->hist_bits);
+            i64(r, "pht_entries", ls->pht_entries);
+            end(r);
+        }
+        end(r);
+    }
+
+    if (stats->loop_enabled) {
+        begin(r, "loop");
+        i64(r, "entries", stats->loop.entries);
+        pred(r, "confident", &stats->loop.confident);
+        pred_sizes(r, "gshare_override", stats->loop.gshare_override, sizes, 1);
+        end(r);
+    }
+
+    if (stats->gshare_sweep_enabled) {
+        begin(r, "gshare_sweep");
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            beginf(r, "%d", sizes[i]);
+            for (int h = 0; h <= MAX_GSHARE_HIST && (1 << h) <= sizes[i]; h++) {
+                beginf(r, "h%d", h);
+                pred_fields(r, &stats->gshare_sweep[i][h]);
+                end(r);
+            }
+            end(r);
+        }
+        end(r);
+    }
+
+    if (stats->counter_variants_enabled) {
+        begin(r, "counter_variants");
+        for (int k = 0; k < NUM_COUNTER_CONFIGS; k++) {
+            const struct CounterVariantStat *cv = &stats->counter_variants[k];
+            char name[REPORT_KEY_MAX];
+            snprintf(name, sizeof name, "%dbit_init%d_%s",
+                     cv->width, cv->init, policy_names[cv->policy]);
+            begin(r, name);
+            pred_sizes(r, "bimodal", cv->bimodal, sizes, 0);
+            pred_sizes(r, "gshare", cv->gshare, sizes, 0);
+            end(r);
+        }
+        end(r);
+    }
+
+    if (stats->aliasing_enabled) {
+        begin(r, "aliasing");
+        alias_sizes(r, "bimodal", stats->alias_bimodal, sizes);
+        alias_sizes(r, "gshare", stats->alias_gshare, sizes);
+        end(r);
+    }
+    end(r);
+}
+
+// Uden -targets er der kun antal hop per type
+static void write_targets(struct Report *r, const struct Stat *stats) {
+    static const char *kind_names[NUM_JUMP_KINDS] = {"direct", "call", "return", "indirect"};
+    const struct TargetStat *tg = &stats->targets;
+
+    if (!stats->targets_enabled) {
+        begin(r, "jumps");
+        for (int k = 0; k < NUM_JUMP_KINDS; k++)
+            u64(r, kind_names[k], tg->kind[k].predictions);
+        end(r);
+        return;
+    }
+    begin(r, "targets");
+    i64(r, "btb_sets", tg->btb_sets);
+    i64(r, "btb_ways", tg->btb_ways);
+    i64(r, "btb_tag_bits", tg->btb_tag_bits);
+    i64(r, "ras_depth", tg->ras_depth);
+    i64(r, "ras_wrap", tg->ras_wrap);
+    i64(r, "itc_entries", tg->itc_entries);
+    i64(r, "itc_hist_bits", tg->itc_hist_bits);
+    for (int k = 0; k < NUM_JUMP_KINDS; k++)
+        pred(r, kind_names[k], &tg->kind[k]);
+    u64(r, "ras_overflows", tg->ras_overflows);
+    u64(r, "ras_underflows", tg->ras_underflows);
+    pred(r, "itc", &tg->itc);
+
+    begin(r, "indirect_sites");
+    for (int i = 0; i < tg->sites->capacity; i++) {
+        const struct IndirectSite *s = &tg->sites->slots[i];
+        if (!s->execs)
+            continue;
+        char name[REPORT_KEY_MAX];
+        snprintf(name, sizeof name, "%08x", s->pc);
+        begin(r, name);
+        u64(r, "execs", s->execs);
+        u64(r, "btb_misses", s->btb_misses);
+        u64(r, "itc_misses", s->itc_misses);
+        end(r);
+    }
+    end(r);
+    end(r);
+}
+
+static const char *class_keys[NUM_BRANCH_CLASSES] = {
+    "always_taken", "never_taken", "biased", "loop", "random"
+};
+
+static const char *prof_pred_keys[NUM_PROF_PREDS] = {
+    "btfnt", "bimodal", "gshare", "tournament", "tage", "perceptron", "local"
+};
+
+static void write_classes(struct Report *r, const struct BranchProfile *prof) {
+    struct BranchClassStat classes[NUM_BRANCH_CLASSES];
+    profile_class_stats(prof, classes);
+
+    begin(r, "branch_classes");
+    for (int c = 0; c < NUM_BRANCH_CLASSES; c++) {
+        begin(r, class_keys[c]);
+        i64(r, "sites", classes[c].sites);
+        u64(r, "execs", classes[c].execs);
+        begin(r, "mispredictions");
+        for (int p = 0; p < NUM_PROF_PREDS; p++)
+            if (prof->enabled & (1u << p))
+                u64(r, prof_pred_keys[p], classes[c].mispreds[p]);
+        end(r);
+        end(r);
+    }
+    end(r);
+}
+
+static void write_cost_model(struct Report *r, const struct CostModel *cm, const struct Stat *stats) {
+    long insns = stats->insns - stats->warmup_insns;
+    begin(r, "cost_model");
+    i64(r, "mispredict_penalty", cm->mispredict_penalty);
+    i64(r, "taken_bubble", cm->taken_bubble);
+    i64(r, "jump_redirect", cm->jump_redirect);
+    f64(r, "perfect_cpi", insns ? (double)cost_base_cycles(cm, stats) / insns : 0.0);
+    end(r);
+}
+
+// Per-branch profilen fra -p: alle branches der er udført, i pc orden
+static void write_branch_sites(struct Report *r, const struct BranchProfile *prof,
+                               struct symbols *symbols) {
+    size_t slots = (prof->text_end - prof->text_start + 3) / 4;
+    begin(r, "branch_sites");
+    for (size_t i = 0; i < slots; i++) {
+        const struct BranchSite *s = &prof->sites[i];
+        if (!s->execs)
+            continue;
+        uint32_t pc = prof->text_start + 4 * (uint32_t)i;
+        unsigned int offset = 0;
+        const char *func = symbols ? symbols_addr_to_func(symbols, pc, &offset) : NULL;
+        char name[REPORT_KEY_MAX];
+        snprintf(name, sizeof name, "%08x", pc);
+        begin(r, name);
+        if (func) {
+            str(r, "function", func);
+            i64(r, "offset", offset);
+        }
+        u64(r, "execs", s->execs);
+        u64(r, "taken", s->taken);
+        str(r, "class", class_keys[profile_classify(s)]);
+        begin(r, "mispredictions");
+        for (int p = 0; p < NUM_PROF_PREDS; p++)
+            if (prof->enabled & (1u << p))
+                u64(r, prof_pred_keys[p], s->mispreds[p]);
+        end(r);
+        end(r);
+    }
+    u64(r, "outside_text", prof->outside_text);
+    end(r);
+}
+
+// Værtstid i sekunder, total og per fase
+static void write_host(struct Report *r, const struct HostTimes *t) {
+    begin(r, "host");
+    f64(r, "wall_seconds", t->wall_total);
+    f64(r, "cpu_seconds", t->cpu_total);
+    for (int p = 0; p < NUM_HOST_PHASES; p++) {
+        begin(r, host_phase_name(p));
+        f64(r, "wall", t->wall[p]);
+        f64(r, "cpu", t->cpu[p]);
+        end(r);
+    }
+    end(r);
+}
+
+void report_write(FILE *out, enum ReportFormat format, const struct ReportRun *run,
+                  const struct Stat *stats, const struct BranchProfile *prof) {
+    int sizes[NUM_PRED_SIZES] = { PREDICTOR_SIZES(PRED_SIZE_ENTRY) };
+    struct Report r = {.out = out, .format = format, .first = {1},
+                       .cost = run->cost, .stats = stats};
+
+    fputs(format == REPORT_JSON ? "{" : "name,value\n", out);
+    str(&r, "program", run->program);
+    i64(&r, "insns", stats->insns);
+    f64(&r, "mips", run->mips);
+    write_host(&r, run->times);
+    u64(&r, "warmup_branches", stats->warmup_branches);
+    i64(&r, "warmup_insns", stats->warmup_insns);
+    write_cost_model(&r, run->cost, stats);
+    write_predictors(&r, stats, sizes);
+    write_targets(&r, stats);
+    if (prof)
+        write_classes(&r, prof);
+    if (prof && run->branch_sites)
+        write_branch_sites(&r, prof, run->symbols);
+    if (format == REPORT_JSON)
+        fputs("\n}\n", out);
+}
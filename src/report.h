@@ -0,0 +1,33 @@
+#ifndef __REPORT_H__
+#define __REPORT_H__
+
+#include <stdio.h>
+#include "simulate.h"
+
+// Maskinlæsbar statistik (-json / -csv) med samme tal som opsummeringen.
+// JSON er ét objekt med en gren per predictor og størrelse, fx
+// predictors.gshare."1024".mispredictions. CSV har en "name,value" linje per
+// tal, hvor name er den samme sti med punktum, så kørsler kan sammenlignes
+// linje for linje.
+
+enum ReportFormat { REPORT_JSON, REPORT_CSV };
+
+struct BranchProfile;
+struct HostTimes;
+struct CostModel;
+struct symbols;
+
+// Om kørslen, udover predictor statistikken
+struct ReportRun {
+    const char *program;
+    double mips;
+    const struct HostTimes *times;
+    const struct CostModel *cost;   // cykler, CPI og speedup per predictor
+    struct symbols *symbols;        // funktionsnavne i branch_sites
+    int branch_sites;               // per-branch profilen (-p) med
+};
+
+void report_write(FILE *out, enum ReportFormat format, const struct ReportRun *run,
+                  const struct Stat *stats, const struct BranchProfile *prof);
+
+#endif
@@ -0,0 +1,90 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include "sampler.h"
+#include "memory.h"
+#include "disassemble.h"
+
+// xorshift64*, samme sekvens for samme seed
+static double next_uniform(struct Sampler *s) {
+    s->rng ^= s->rng >> 12;
+    s->rng ^= s->rng << 25;
+    s->rng ^= s->rng >> 27;
+    uint64_t r = s->rng * 0x2545F4914F6CDD1DULL;
+    return ((r >> 11) + 1) * (1.0 / 9007199254740992.0);    // (0, 1]
+}
+
+// Afstand til næste sample, mindst 1
+static long next_gap(struct Sampler *s) {
+    if (s->period > 0)
+        return s->period;
+    if (s->rate >= 1.0)
+        return 1;
+    double gap = floor(log(next_uniform(s)) / log1p(-s->rate)) + 1;
+    return gap < (double)LONG_MAX / 2 ? (long)gap : LONG_MAX / 2;
+}
+
+struct Sampler *sampler_create(FILE *out, long period, double rate, uint64_t seed,
+                               struct symbols *symbols) {
+    if (period <= 0 && !(rate > 0 && rate <= 1.0))
+        return NULL;
+    struct Sampler *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+        return NULL;
+    s->out = out;
+    s->period = period;
+    s->rate = rate;
+    s->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    s->symbols = symbols;
+    s->next = next_gap(s);
+    if (period > 0)
+        fprintf(out, "# 1 sample per %ld instructions\n", period);
+    else
+        fprintf(out, "# random samples, rate %g, seed %llu\n", rate, (unsigned long long)seed);
+    return s;
+}
+
+void sampler_close(struct Sampler *s, long insns) {
+    if (s == NULL)
+        return;
+    fprintf(s->out, "# %ld samples of %ld instructions\n", s->samples, insns);
+    fclose(s->out);
+    free(s);
+}
+
+void sampler_take(struct Sampler *s, long insn, uint32_t pc, uint32_t inst,
+                  const int32_t regs[32], struct memory *mem) {
+    char text[100];
+    disassemble(pc, inst, text, sizeof(text), s->symbols);
+    fprintf(s->out, "%8ld  %08x : %08x   %s\n", insn, pc, inst, text);
+
+    // load/store: effektiv adresse og lagerets nuværende indhold
+    uint32_t opcode = inst & 0x7F;
+    if (opcode == 0x03 || opcode == 0x23) {
+        uint32_t funct3 = (inst >> 12) & 0x7;
+        int32_t imm;
+        if (opcode == 0x03) {
+            imm = (int32_t)inst >> 20;
+        } else {
+            imm = ((inst >> 7) & 0x1F) | ((inst >> 25) << 5);
+            if (imm & 0x800) imm |= 0xFFFFF000;
+        }
+        uint32_t addr = (uint32_t)regs[(inst >> 15) & 0x1F] + imm;
+        int size = 1 << (funct3 & 0x3);
+        uint32_t value = size == 1 ? (uint32_t)memory_rd_b(mem, addr)
+                       : size == 2 ? (uint32_t)memory_rd_h(mem, addr)
+                       : (uint32_t)memory_rd_w(mem, addr);
+        fprintf(s->out, "          %s [%08x] size %d, memory = %0*x\n",
+                opcode == 0x03 ? "load " : "store", addr, size, 2 * size, value);
+    }
+
+    for (int r = 0; r < 32; r += 8) {
+        fprintf(s->out, "          x%-2d", r);
+        for (int k = r; k < r + 8; k++)
+            fprintf(s->out, " %08x", (uint32_t)regs[k]);
+        fprintf(s->out, "\n");
+    }
+
+    s->samples++;
+    s->next = insn + next_gap(s);
+}
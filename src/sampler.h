@@ -0,0 +1,36 @@
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Samplet tracing (-sample / -sample-rate): i stedet for at logge alle
+// instruktioner skrives én instruktion med fuld kontekst (registre før
+// udførelse og evt. lagerværdi ved load/store) med jævne eller tilfældige
+// mellemrum. Tilfældig sampling bruger geometrisk fordelte afstande, så hver
+// instruktion samples uafhængigt med sandsynlighed 'rate'.
+
+struct memory;
+struct symbols;
+
+struct Sampler {
+    FILE *out;
+    long period;        // fast afstand, 0 = tilfældig
+    double rate;        // sandsynlighed per instruktion når period = 0
+    uint64_t rng;
+    long next;          // instruktionsnummer for næste sample
+    long samples;
+    struct symbols *symbols;
+};
+
+// NULL ved fejl. Enten period > 0, eller 0 < rate <= 1. Filen lukkes af sampler_close.
+struct Sampler *sampler_create(FILE *out, long period, double rate, uint64_t seed,
+                               struct symbols *symbols);
+// Skriver en opsummering og lukker filen
+void sampler_close(struct Sampler *s, long insns);
+
+// Skriver sample for instruktion nr. insn (før den udføres) og vælger næste
+void sampler_take(struct Sampler *s, long insn, uint32_t pc, uint32_t inst,
+                  const int32_t regs[32], struct memory *mem);
+
+#endif
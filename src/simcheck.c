@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "commit.h"
+#include "disassemble.h"
+
+// Sammenligner to commit logs (sim -c) record for record og stopper ved den
+// første forskel. Logs kan læses fra pipes, så to engines kan køre i lockstep:
+//   simcheck <(sim prog.elf -c /dev/fd/3 3>&1 >/dev/null) <(andensim ... 3>&1 >/dev/null)
+
+static void usage(void)
+{
+  printf("simcheck: Usage:\n");
+  printf("  simcheck commits-a commits-b   // report the first instruction where the logs differ\n");
+  exit(-1);
+}
+
+static FILE *open_log(const char *name)
+{
+  FILE *f = fopen(name, "rb");
+  if (f == NULL || commit_read_magic(f) != 0)
+  {
+    printf("%s is not a commit log\n", name);
+    exit(-1);
+  }
+  return f;
+}
+
+static void print_record(const char *name, const struct CommitRecord *r)
+{
+  char buf[128];
+  disassemble(r->pc, r->inst, buf, sizeof buf, NULL);
+  printf("  %-10s %08x : %08x   %-32s", name, r->pc, r->inst, buf);
+  if (r->flags & COMMIT_REG)
+    printf("  x%-2u = %08x", r->rd, r->rd_value);
+  if (r->flags & COMMIT_STORE)
+    printf("  [%08x] = %0*x", r->store_addr, 2 * r->store_size, r->store_data);
+  printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3)
+    usage();
+  FILE *a = open_log(argv[1]);
+  FILE *b = open_log(argv[2]);
+
+  struct CommitRecord ra, rb;
+  long int insns = 0;
+  for (;;)
+  {
+    int sa = commit_read(a, &ra);
+    int sb = commit_read(b, &rb);
+    if (sa < 0 || sb < 0)
+    {
+      printf("Truncated record after %ld instructions in %s\n", insns, sa < 0 ? argv[1] : argv[2]);
+      return 2;
+    }
+    if (sa == 0 || sb == 0)
+    {
+      if (sa == sb)
+      {
+        printf("Identical: %ld instructions\n", insns);
+        return 0;
+      }
+      printf("%s ends after %ld instructions, %s continues\n",
+             sa == 0 ? argv[1] : argv[2], insns, sa == 0 ? argv[2] : argv[1]);
+      return 1;
+    }
+    insns++;
+    if (!commit_equal(&ra, &rb))
+    {
+      printf("Divergence at instruction %ld:\n", insns);
+      print_record(argv[1], &ra);
+      print_record(argv[2], &rb);
+      return 1;
+    }
+  }
+}
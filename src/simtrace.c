@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "disassemble.h"
+#include "lz.h"
+#include "memtrace.h"
+
+// Viser et binært trace fra 'sim -t' i samme tekstformat som 'sim -l', eller
+// et memory trace fra 'sim -m'.
+// Komprimerede filer (sim -z) pakkes ud undervejs.
+
+static void usage(void)
+{
+  printf("simtrace: Usage:\n");
+  printf("  simtrace trace        // print trace in the same format as sim -l\n");
+  printf("  simtrace trace -v     // ... with register writeback and memory address\n");
+  printf("  simtrace mem -m       // print memory trace from sim -m: pc, r/w, size and address\n");
+  printf("  simtrace file -d      // decompress a file written with sim -z (e.g. a -l log) to stdout\n");
+  exit(-1);
+}
+
+static int print_memtrace(FILE *in, const char *name)
+{
+  struct MemTraceReader *mr = memtrace_reader_open(in);
+  if (mr == NULL)
+  {
+    printf("%s is not a sim memory trace (-din traces are already text)\n", name);
+    exit(-1);
+  }
+  struct MemAccess rec;
+  long int accesses = 0;
+  int status;
+  while ((status = memtrace_read(mr, &rec)) > 0)
+  {
+    accesses++;
+    printf("%8ld  %08x : %c %d [%08x]\n", accesses, rec.pc, rec.write ? 'W' : 'R', rec.size, rec.addr);
+  }
+  if (status < 0)
+    fprintf(stderr, "Corrupt memory trace after %ld accesses\n", accesses);
+  memtrace_reader_close(mr);
+  fclose(in);
+  return status < 0;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2 || argc > 3)
+    usage();
+  int verbose = 0;
+  int decompress = 0;
+  int memory = 0;
+  if (argc == 3)
+  {
+    if (!strcmp(argv[2], "-v"))
+      verbose = 1;
+    else if (!strcmp(argv[2], "-d"))
+      decompress = 1;
+    else if (!strcmp(argv[2], "-m"))
+      memory = 1;
+    else
+      usage();
+  }
+  FILE *in = fopen(argv[1], "rb");
+  if (in == NULL)
+  {
+    printf("Could not open trace file %s\n", argv[1]);
+    exit(-1);
+  }
+  if (lz_check_magic(in) && (in = lz_open_read(in)) == NULL)
+  {
+    printf("Could not set up decompression\n");
+    exit(-1);
+  }
+  if (decompress)
+  {
+    char buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, in)) > 0)
+      fwrite(buf, 1, n, stdout);
+    int status = ferror(in);
+    if (status)
+      fprintf(stderr, "Corrupt compressed file\n");
+    fclose(in);
+    return status != 0;
+  }
+  if (memory)
+    return print_memtrace(in, argv[1]);
+  struct TraceReader *tr = trace_reader_open(in);
+  if (tr == NULL)
+  {
+    printf("%s is not a sim trace (RVT1 traces from older versions must be recorded again)\n", argv[1]);
+    exit(-1);
+  }
+
+  struct TraceInsn rec;
+  long int insns = 0;
+  int status;
+  char buf[128];
+  while ((status = trace_read(tr, &rec)) > 0)
+  {
+    insns++;
+    disassemble(rec.pc, rec.inst, buf, sizeof buf, NULL);
+    if (!verbose)
+    {
+      printf("%8ld  %08x : %08x   %s\n", insns, rec.pc, rec.inst, buf);
+      continue;
+    }
+    printf("%8ld  %08x : %08x   %-36s", insns, rec.pc, rec.inst, buf);
+    if (rec.rd)
+      printf("  x%-2u = %08x", rec.rd, rec.value);
+    if (rec.has_mem)
+      printf("  [%08x]", rec.mem_addr);
+    printf("\n");
+  }
+  if (status < 0)
+    fprintf(stderr, "Corrupt trace after %ld instructions\n", insns);
+
+  trace_reader_close(tr);
+  fclose(in);
+  return status < 0;
+}
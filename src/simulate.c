@@ -1,47 +1,523 @@
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "simulate.h"
 #include "memory.h"
 #include "disassemble.h"
 #include "read_elf.h"   // for struct symbols
+#include "predictors.h"
+#include "profile.h"
+#include "alias.h"
+#include "snapshot.h"
+#include "trace.h"
+#include "logwriter.h"
+#include "disasm_cache.h"
+#include "tracefilter.h"
+#include "commit.h"
+#include "sampler.h"
+#include "memtrace.h"
 
 
 // Tabelstørrelser til Bimodal og gShare
-static const int predictor_sizes[NUM_PRED_SIZES] = {256, 1024, 4096, 16384};
+static const int predictor_sizes[NUM_PRED_SIZES] = { PREDICTOR_SIZES(PRED_SIZE_ENTRY) };
+
+// Tjekker konfigurationen ved compile time
+#define CHECK_PRED_SIZE(idx, size, ghist, phist)                                  \
+    _Static_assert((idx) >= 0 && (idx) < 31, "predictor index out of range");    \
+    _Static_assert((size) > 0 && ((size) & ((size) - 1)) == 0 && (size) <= MAX_PRED_SIZE, \
+                   "predictor size must be a power of two <= 2^MAX_GSHARE_HIST"); \
+    _Static_assert((ghist) >= 0 && (ghist) <= MAX_GSHARE_HIST,                    \
+                   "gShare history must be 0..MAX_GSHARE_HIST bits");
+PREDICTOR_SIZES(CHECK_PRED_SIZE)
+#undef CHECK_PRED_SIZE
+// Hvert index præcis én gang: summen af 2^idx er kun 2^n - 1 når alle er forskellige
+#define PRED_INDEX_BIT(idx, size, ghist, phist) + (1u << (idx))
+_Static_assert((0 PREDICTOR_SIZES(PRED_INDEX_BIT)) == (1u << NUM_PRED_SIZES) - 1,
+               "predictor indexes must be 0, 1, 2, ... without repeats");
+#undef PRED_INDEX_BIT
 
 // 2-bit tilstandsmaskiner 
-static uint8_t bimodal_tables[NUM_PRED_SIZES][16384];
-static uint8_t gshare_tables[NUM_PRED_SIZES][16384];
+static uint8_t bimodal_tables[NUM_PRED_SIZES][MAX_PRED_SIZE];
+static uint8_t gshare_tables[NUM_PRED_SIZES][MAX_PRED_SIZE];
+
+// Tournament chooser: 2-bit, taget = brug gShare, ikke taget = brug bimodal
+static uint8_t chooser_tables[NUM_PRED_SIZES][MAX_PRED_SIZE];
 
-// Global History Register til gShare
+// Global History Register til gShare. Hver størrelse bruger sine egne
+// gshare_hist_bits[i] nyeste bits (højst MAX_GSHARE_HIST).
 static uint32_t ghr = 0;
-static const int ghr_bits = 14; 
+static const int gshare_hist_bits[NUM_PRED_SIZES] = { PREDICTOR_SIZES(PRED_GHIST_ENTRY) };
+
+// Sweep: en gShare per (størrelse, historielængde 0..log2(størrelse))
+static uint8_t gshare_sweep_tables[NUM_PRED_SIZES][MAX_GSHARE_HIST + 1][MAX_PRED_SIZE];
+static int gshare_sweep_max[NUM_PRED_SIZES];    // log2(størrelse)
+
+// TAGE med samme storage som gShare tabellerne (2 bits per entry)
+static struct Tage tage_preds[NUM_PRED_SIZES];
+
+// Hashed perceptron med samme storage og en historielængde per størrelse
+static struct Perceptron perc_preds[NUM_PRED_SIZES];
+static const int perceptron_hist_lengths[NUM_PRED_SIZES] = { PREDICTOR_SIZES(PRED_PHIST_ENTRY) };
 
-// 2-bit counter: MSB bestemmer taget/ikke taget
+// Lokal historie predictors: {BHT entries, historiebits, PHT entries}.
+// PHT = 2^historiebits giver PAg, større PHT giver PAp med PC-valgte sæt.
+// Bruges når -local-config ikke er givet.
+static const struct LocalConfig default_local_configs[] = {
+    {  256,  8,   256},     // PAg
+    { 1024, 10,  1024},     // PAg
+    { 1024,  8,  4096},     // PAp, 16 sæt
+    { 1024, 10, 16384},     // PAp, 16 sæt
+};
+#define NUM_DEFAULT_LOCAL_CONFIGS (int)(sizeof default_local_configs / sizeof default_local_configs[0])
+static struct LocalPred local_preds[MAX_LOCAL_CONFIGS];
+static int num_local;   // 0 uden -local
+
+// Loop predictor, bruges alene og som override på hver gShare størrelse
+static const int loop_entries = 64;
+static struct LoopPred loop_pred;
+// Per gShare størrelse: 7-bit signed tæller der lærer om override hjælper (som L-TAGE)
+static int8_t loop_useful[NUM_PRED_SIZES];
+
+// BTB og RAS til target prediction af jal/jalr, geometri fra opts->target_cfg
+static struct Btb btb;
+static struct Ras ras;
+
+// Path history target cache til indirekte jalr
+static struct TargetCache itc;
+
+// 2-bit counter: MSB bestemmer taget/ikke taget (00,01 -> ikke taget, 10,11 -> taget)
 static inline int counter_predict(uint8_t c) {
-    // 00,01 -> 0 (ikke taget), 10,11 -> 1 (taget)
-    return (c >> 1) & 1;
+    return ctr2_predict(c);
 }
 
 static inline uint8_t counter_update(uint8_t c, int taken) {
-    if (taken) {
-        if (c < 3) c++;
-    } else {
-        if (c > 0) c--;
-    }
-    return c;
+    return ctr2_sat(c, taken);
 }
 
-static void init_predictors(void) {
+// En predictor der ikke kan oprettes ville crashe ved første branch
+static void predictor_error(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, ", terminating.\n");
+    exit(-1);
+}
+
+// Tællervarianter til bimodal og gShare (-counters):
+//   X(index, bredde, starttilstand, politik)
+// politik er suffikset på ctrW_step_*, så hver linje kalder sin egen step
+// funktion direkte. Linje 1 svarer til standard bimodal/gShare.
+#define COUNTER_CONFIGS(X)  \
+    X(0, 1, 0, sat)         \
+    X(1, 2, 1, sat)         \
+    X(2, 2, 1, hyst)        \
+    X(3, 2, 1, prob)        \
+    X(4, 3, 3, sat)         \
+    X(5, 3, 3, hyst)        \
+    X(6, 4, 7, sat)         \
+    X(7, 4, 7, prob)
+
+#define COUNTER_CONFIG_ENTRY(k, width, init, pol) [k] = {width, init, COUNTER_POLICY(pol)},
+#define COUNTER_CONFIG_ONE(k, width, init, pol) + 1
+static const int counter_configs[NUM_COUNTER_CONFIGS][3] = { COUNTER_CONFIGS(COUNTER_CONFIG_ENTRY) };
+_Static_assert((0 COUNTER_CONFIGS(COUNTER_CONFIG_ONE)) == NUM_COUNTER_CONFIGS,
+               "COUNTER_CONFIGS must have NUM_COUNTER_CONFIGS lines");
+#undef COUNTER_CONFIG_ENTRY
+#undef COUNTER_CONFIG_ONE
+static struct CounterTable counter_bimodal[NUM_COUNTER_CONFIGS][NUM_PRED_SIZES];
+static struct CounterTable counter_gshare[NUM_COUNTER_CONFIGS][NUM_PRED_SIZES];
+
+// Aliasing analyse af bimodal og gShare (-aliasing)
+static struct AliasTracker alias_bimodal[NUM_PRED_SIZES];
+static struct AliasTracker alias_gshare[NUM_PRED_SIZES];
+
+static void init_predictors(const struct SimOptions *opts) {
     // Sætter alle counters til "svagt ikke taget" 
     for (int i = 0; i < NUM_PRED_SIZES; i++) {
         int size = predictor_sizes[i];
         for (int j = 0; j < size; j++) {
             bimodal_tables[i][j] = 1;
             gshare_tables[i][j]  = 1;
+            chooser_tables[i][j] = 1;
         }
     }
     ghr = 0;
+
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        int size = predictor_sizes[i];
+        gshare_sweep_max[i] = 0;
+        while ((1 << gshare_sweep_max[i]) < size)
+            gshare_sweep_max[i]++;
+        if (!opts->gshare_sweep)
+            continue;
+        for (int h = 0; h <= gshare_sweep_max[i]; h++)
+            for (int j = 0; j < size; j++)
+                gshare_sweep_tables[i][h][j] = 1;
+    }
+
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        if (opts->tage && tage_init(&tage_preds[i], predictor_sizes[i] * 2) != 0)
+            predictor_error("Could not set up TAGE with a budget of %d bits", predictor_sizes[i] * 2);
+        if (opts->perceptron &&
+            perceptron_init(&perc_preds[i], predictor_sizes[i] * 2, perceptron_hist_lengths[i]) != 0)
+            predictor_error("Invalid perceptron config: %d bits, history %d",
+                            predictor_sizes[i] * 2, perceptron_hist_lengths[i]);
+    }
+
+    for (int k = 0; k < NUM_COUNTER_CONFIGS && opts->counter_variants; k++) {
+        const int *cfg = counter_configs[k];
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            if (counter_table_init(&counter_bimodal[k][i], predictor_sizes[i], cfg[0], cfg[1], cfg[2]) != 0 ||
+                counter_table_init(&counter_gshare[k][i], predictor_sizes[i], cfg[0], cfg[1], cfg[2]) != 0)
+                predictor_error("Could not set up %d-bit counters with init %d and policy %d",
+                                cfg[0], cfg[1], cfg[2]);
+        }
+    }
+
+    for (int i = 0; i < NUM_PRED_SIZES && opts->aliasing; i++) {
+        if (alias_init(&alias_bimodal[i], predictor_sizes[i]) != 0 ||
+            alias_init(&alias_gshare[i], predictor_sizes[i]) != 0)
+            predictor_error("Could not set up aliasing analysis for %d entries", predictor_sizes[i]);
+    }
+
+    const struct LocalConfig *local_cfg = opts->num_local_cfg ? opts->local_cfg : default_local_configs;
+    num_local = !opts->local ? 0 : opts->num_local_cfg ? opts->num_local_cfg : NUM_DEFAULT_LOCAL_CONFIGS;
+    for (int i = 0; i < num_local; i++) {
+        const struct LocalConfig *cfg = &local_cfg[i];
+        if (local_init(&local_preds[i], cfg->bht_entries, cfg->hist_bits, cfg->pht_entries) != 0)
+            predictor_error("Could not set up a local predictor with bht=%d hist=%d pht=%d",
+                            cfg->bht_entries, cfg->hist_bits, cfg->pht_entries);
+    }
+
+    for (int i = 0; i < NUM_PRED_SIZES; i++)
+        loop_useful[i] = 0;
+    if (opts->loop && loop_init(&loop_pred, loop_entries) != 0)
+        predictor_error("Could not set up a loop predictor with %d entries", loop_entries);
+
+    if (!opts->targets)
+        return;
+    const struct TargetConfig *cfg = &opts->target_cfg;
+    if (btb_init(&btb, cfg->btb_sets, cfg->btb_ways, cfg->btb_tag_bits) != 0)
+        predictor_error("Could not set up a BTB with %d sets, %d ways and %d-bit tags",
+                        cfg->btb_sets, cfg->btb_ways, cfg->btb_tag_bits);
+    if (ras_init(&ras, cfg->ras_depth, cfg->ras_wrap ? RAS_OVERFLOW_WRAP : RAS_OVERFLOW_DROP) != 0)
+        predictor_error("Could not set up a RAS of depth %d", cfg->ras_depth);
+    if (tc_init(&itc, cfg->itc_entries, cfg->itc_hist_bits) != 0)
+        predictor_error("Could not set up an indirect target cache with %d entries and %d history bits",
+                        cfg->itc_entries, cfg->itc_hist_bits);
+}
+
+// Predictors i per-branch profilen der faktisk kører
+static unsigned profile_mask(const struct SimOptions *opts) {
+    unsigned mask = 1u << PROF_BTFNT | 1u << PROF_BIMODAL | 1u << PROF_GSHARE;
+    if (opts->tournament)
+        mask |= 1u << PROF_TOURNAMENT;
+    if (opts->tage)
+        mask |= 1u << PROF_TAGE;
+    if (opts->perceptron)
+        mask |= 1u << PROF_PERCEPTRON;
+    if (opts->local)
+        mask |= 1u << PROF_LOCAL;
+    return mask;
+}
+
+#define INDIRECT_SITES_INIT 256
+
+static struct IndirectSites *indirect_sites_create(int capacity) {
+    struct IndirectSites *sites = malloc(sizeof *sites);
+    if (!sites)
+        return NULL;
+    sites->slots = calloc(capacity, sizeof(struct IndirectSite));
+    sites->capacity = capacity;
+    sites->count = 0;
+    if (!sites->slots) {
+        free(sites);
+        return NULL;
+    }
+    return sites;
+}
+
+void indirect_sites_delete(struct IndirectSites *sites) {
+    if (sites)
+        free(sites->slots);
+    free(sites);
+}
+
+static struct IndirectSite *indirect_probe(struct IndirectSites *sites, uint32_t pc) {
+    uint32_t mask = sites->capacity - 1;
+    uint32_t h = ((pc >> 2) * 0x9E3779B1u) & mask;
+    while (sites->slots[h].used && sites->slots[h].pc != pc)
+        h = (h + 1) & mask;
+    return &sites->slots[h];
+}
+
+// Finder eller opretter site for pc. Tabellen fordobles når den er halvt fyldt.
+static struct IndirectSite *indirect_site(struct IndirectSites *sites, uint32_t pc) {
+    struct IndirectSite *site = indirect_probe(sites, pc);
+    if (site->used)
+        return site;
+    if (2 * (sites->count + 1) > sites->capacity) {
+        struct IndirectSite *old = sites->slots;
+        int old_capacity = sites->capacity;
+        sites->slots = calloc(2 * old_capacity, sizeof(struct IndirectSite));
+        if (!sites->slots)
+            predictor_error("Out of memory for %d indirect jump sites", sites->count + 1);
+        sites->capacity = 2 * old_capacity;
+        for (int i = 0; i < old_capacity; i++)
+            if (old[i].used)
+                *indirect_probe(sites, old[i].pc) = old[i];
+        free(old);
+        site = indirect_probe(sites, pc);
+    }
+    site->used = 1;
+    site->pc = pc;
+    sites->count++;
+    return site;
+}
+
+// Warmup: sites bliver i tabellen, kun tællerne nulstilles
+static void indirect_sites_reset(struct IndirectSites *sites) {
+    for (int i = 0; sites && i < sites->capacity; i++) {
+        sites->slots[i].execs = 0;
+        sites->slots[i].btb_misses = 0;
+        sites->slots[i].itc_misses = 0;
+    }
+}
+
+// Snapshots til warmup og intervaller
+static struct Stat warmup_snapshot;
+static int warmup_done;
+static struct Stat interval_prev;
+static long next_interval;
+
+// Kopierer stats inkl. tællere der ellers først samles op til sidst
+static void take_snapshot(struct Stat *dst, const struct Stat *src) {
+    *dst = *src;
+    dst->targets.ras_overflows = ras.overflows;
+    dst->targets.ras_underflows = ras.underflows;
+}
+
+static void write_interval(const struct Stat *stats, const struct SimOptions *opts) {
+    struct Stat cur;
+    take_snapshot(&cur, stats);
+    interval_write(opts->interval_file, &cur, &interval_prev);
+    interval_prev = cur;
+    next_interval += opts->interval;
+}
+
+static struct LogWriter *log_writer;
+static struct DisasmCache *log_cache;   // kun når -l skrives uden tråd
+
+// Samler de sidste tællere op, fratrækker warmup og frigiver predictor tabellerne
+static void finish_predictors(struct Stat *stats, const struct SimOptions *opts) {
+    // loggen skal være skrevet færdig før main skriver opsummeringen
+    log_writer_stop(log_writer);
+    log_writer = NULL;
+    disasm_cache_delete(log_cache);
+    log_cache = NULL;
+
+    stats->targets.ras_overflows = ras.overflows;
+    stats->targets.ras_underflows = ras.underflows;
+
+    // sidste, ufuldstændige interval
+    if (opts->interval_file && stats->insns > interval_prev.insns)
+        write_interval(stats, opts);
+    if (opts->warmup) {
+        // kortere program end warmup: intet tælles med
+        if (!warmup_done) {
+            warmup_snapshot = *stats;
+            indirect_sites_reset(stats->targets.sites);
+        }
+        stat_subtract(stats, &warmup_snapshot);
+        stats->warmup_branches = warmup_snapshot.nt.predictions;
+        stats->warmup_insns = warmup_snapshot.insns;
+    }
+
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        tage_free(&tage_preds[i]);
+        perceptron_free(&perc_preds[i]);
+    }
+    for (int i = 0; i < NUM_PRED_SIZES && stats->aliasing_enabled; i++) {
+        alias_finish(&alias_bimodal[i], &stats->alias_bimodal[i]);
+        alias_finish(&alias_gshare[i], &stats->alias_gshare[i]);
+        alias_free(&alias_bimodal[i]);
+        alias_free(&alias_gshare[i]);
+    }
+    for (int k = 0; k < NUM_COUNTER_CONFIGS; k++) {
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            counter_table_free(&counter_bimodal[k][i]);
+            counter_table_free(&counter_gshare[k][i]);
+        }
+    }
+    for (int i = 0; i < num_local; i++)
+        local_free(&local_preds[i]);
+    loop_free(&loop_pred);
+    btb_free(&btb);
+    ras_free(&ras);
+    tc_free(&itc);
+}
+
+// x1 (ra) og x5 (t0) er link registre i RISC-V calling convention
+static inline int is_link_reg(uint32_t r) {
+    return r == 1 || r == 5;
+}
+
+// Slår target op i BTB'en, tæller hit/miss for den givne type hop og opdaterer.
+// Returnerer 1 ved miss.
+static int btb_predict_jump(struct Stat *stats, enum JumpKind kind,
+                            uint32_t pc, uint32_t target) {
+    uint32_t pred;
+    int miss = 0;
+    stats->targets.kind[kind].predictions++;
+    if (!btb_lookup(&btb, pc, &pred) || pred != target) {
+        stats->targets.kind[kind].mispredictions++;
+        miss = 1;
+    }
+    btb_update(&btb, pc, target);
+    return miss;
+}
+
+// Indirekte hop: target cache med BTB'en som fallback, plus per-site tællere
+static void predict_indirect(struct Stat *stats, uint32_t pc, uint32_t target) {
+    int btb_miss = btb_predict_jump(stats, JUMP_INDIRECT, pc, target);
+
+    uint32_t pred;
+    int itc_miss;
+    if (tc_predict(&itc, pc, &pred))
+        itc_miss = (pred != target);
+    else
+        itc_miss = btb_miss;     // ingen entry: BTB'ens forudsigelse bruges
+    tc_update(&itc, target);
+
+    stats->targets.itc.predictions++;
+    if (itc_miss)
+        stats->targets.itc.mispredictions++;
+
+    struct IndirectSite *site = indirect_site(stats->targets.sites, pc);
+    site->execs++;
+    site->btb_misses += btb_miss;
+    site->itc_misses += itc_miss;
+}
+
+// Alle predictors af én størrelse. Kaldes med konstante argumenter for hver linje
+// i PREDICTOR_SIZES, så løkken over størrelser rulles ud og masker og
+// tabeladresser bliver konstanter efter inlining. Med full = 0 er kun de
+// fire standard predictors tilbage.
+static inline __attribute__((always_inline))
+void predict_size(struct Stat *stats, const struct SimOptions *opts, const int full,
+                  const int i, const uint32_t mask, const int hist_bits,
+                  uint32_t pc, int actual_taken, int loop_confident, int loop_p,
+                  uint8_t wrong[NUM_PROF_PREDS])
+{
+    uint32_t pc_index = pc >> 2;
+
+    // Bimodal
+    int idx = pc_index & mask;
+    uint8_t c = bimodal_tables[i][idx];
+    int pred = counter_predict(c);
+    int bimodal_pred = pred;
+
+    stats->bimodal[i].predictions++;
+    if (pred != actual_taken)
+        stats->bimodal[i].mispredictions++;
+    wrong[PROF_BIMODAL] = (pred != actual_taken);
+
+    bimodal_tables[i][idx] = counter_update(c, actual_taken);
+
+    // gShare
+    uint32_t ghr_local = ghr & ((1u << hist_bits) - 1);
+    int gidx = (int)((pc_index ^ ghr_local) & mask);
+    c = gshare_tables[i][gidx];
+    pred = counter_predict(c);
+    int gshare_pred = pred;
+
+    stats->gshare[i].predictions++;
+    if (pred != actual_taken)
+        stats->gshare[i].mispredictions++;
+    wrong[PROF_GSHARE] = (pred != actual_taken);
+
+    gshare_tables[i][gidx] = counter_update(c, actual_taken);
+
+    if (full && opts->aliasing) {
+        if (alias_access(&alias_bimodal[i], &stats->alias_bimodal[i], idx, pc_index,
+                         actual_taken, bimodal_pred == actual_taken) != 0 ||
+            alias_access(&alias_gshare[i], &stats->alias_gshare[i], gidx,
+                         ((uint64_t)pc_index << 32) | ghr_local,
+                         actual_taken, gshare_pred == actual_taken) != 0)
+            predictor_error("Out of memory in the aliasing analysis for %d entries",
+                            alias_bimodal[i].entries);
+    }
+
+    // gShare med loop predictor som override
+    if (full && opts->loop) {
+        pred = (loop_confident && loop_useful[i] >= 0) ? loop_p : gshare_pred;
+        stats->loop.gshare_override[i].predictions++;
+        if (pred != actual_taken)
+            stats->loop.gshare_override[i].mispredictions++;
+        if (loop_confident && loop_p != gshare_pred) {
+            if (loop_p == actual_taken) {
+                if (loop_useful[i] < 63) loop_useful[i]++;
+            } else {
+                if (loop_useful[i] > -64) loop_useful[i]--;
+            }
+        }
+    }
+
+    // Tournament: chooser indekseret som bimodal, genbruger
+    // de to predictions ovenfor
+    if (full && opts->tournament) {
+        c = chooser_tables[i][idx];
+        struct TournamentStat *ts = &stats->tournament[i];
+        if (counter_predict(c)) {
+            pred = gshare_pred;
+            ts->chose_gshare++;
+            if (pred == actual_taken) ts->gshare_correct++;
+        } else {
+            pred = bimodal_pred;
+            ts->chose_bimodal++;
+            if (pred == actual_taken) ts->bimodal_correct++;
+        }
+        ts->pred.predictions++;
+        if (pred != actual_taken)
+            ts->pred.mispredictions++;
+        wrong[PROF_TOURNAMENT] = (pred != actual_taken);
+
+        // Chooser trænes kun når de to er uenige: mod gShare hvis den havde ret
+        if (bimodal_pred != gshare_pred)
+            chooser_tables[i][idx] = counter_update(c, gshare_pred == actual_taken);
+    }
+
+    // TAGE
+    if (full && opts->tage) {
+        pred = tage_predict(&tage_preds[i], pc);
+        stats->tage[i].predictions++;
+        if (pred != actual_taken)
+            stats->tage[i].mispredictions++;
+        wrong[PROF_TAGE] = (pred != actual_taken);
+        tage_update(&tage_preds[i], pc, actual_taken);
+    }
+
+    // Hashed perceptron
+    if (full && opts->perceptron) {
+        pred = perceptron_predict(&perc_preds[i], pc);
+        stats->perceptron[i].predictions++;
+        if (pred != actual_taken)
+            stats->perceptron[i].mispredictions++;
+        wrong[PROF_PERCEPTRON] = (pred != actual_taken);
+        perceptron_update(&perc_preds[i], actual_taken);
+    }
+}
+
+// Opcodes der skriver rd, til writeback i trace og commit log
+static inline int writes_rd(uint32_t opcode) {
+    switch (opcode) {
+    case 0x33: case 0x13: case 0x03: case 0x37: case 0x17: case 0x6F: case 0x67:
+        return 1;
+    default:
+        return 0;
+    }
 }
 
 // x0 må aldrig skrives til
@@ -49,17 +525,39 @@ static inline void write_reg(int32_t regs[32], uint32_t rd, int32_t value) {
     if (rd != 0) regs[rd] = value;
 }
 
-struct Stat simulate(struct memory *mem, int start_addr,
-                     FILE *log_file, struct symbols* symbols)
+// Fortolkerløkken. Inlines tre gange fra simulate: med full = 0 er alle
+// valgfrie predictors og analyser væk ved compile time, og med io = 0 er
+// traces, -l, sampling og snapshots væk, så en kørsel kun betaler for
+// tests på opts ved hver instruktion og branch for det den bruger.
+static inline __attribute__((always_inline))
+struct Stat run(struct Stat stats, struct memory *mem, uint32_t pc,
+                FILE *log_file, struct symbols* symbols,
+                const struct SimOptions *opts, const int full, const int io)
 {
-    struct Stat stats = {0};
-
-    // init branch predictors for hver simulering
-    init_predictors();
-
     int32_t regs[32] = {0};       // x0..x31
-    uint32_t pc = (uint32_t)start_addr;
+    struct TraceWriter *trace = io ? opts->trace : NULL;
+    struct CommitWriter *commit = io ? opts->commit : NULL;
+    struct MemTraceWriter *memtrace = io ? opts->memtrace : NULL;
+    // næste instruktion der samples, -1 = ingen sampling
+    struct Sampler *sampler = io ? opts->sampler : NULL;
+    long next_sample = sampler ? sampler->next : -1;
+    // -l skrives af en separat tråd; uden tråd skrives direkte
+    log_writer = log_file ? log_writer_start(log_file, symbols) : NULL;
+    if (log_file && !log_writer)
+        log_cache = disasm_cache_create(symbols);
 
+    // -l vindue: log_on skiftes når insns når log_toggle, -1 = aldrig
+    const struct TraceFilter *log_filter = opts->log_filter;
+    int log_on = log_file != NULL;
+    long log_toggle = -1;
+    if (log_file && log_filter) {
+        if (log_filter->start > 1) {
+            log_on = 0;
+            log_toggle = log_filter->start;
+        } else if (log_filter->end > 0) {
+            log_toggle = log_filter->end;
+        }
+    }
     for (;;) {
         uint32_t inst = (uint32_t)memory_rd_w(mem, pc);
         stats.insns++;
@@ -73,11 +571,24 @@ struct Stat simulate(struct memory *mem, int start_addr,
 
         uint32_t next_pc = pc + 4;
         
-        if (log_file) {
-            char buf[128];
-            disassemble(pc, inst, buf, sizeof buf, symbols);
-            fprintf(log_file, "%8ld  %08x : %08x   %s\n",
-                    stats.insns, pc, inst, buf);
+        if (trace)
+            trace_begin(trace, pc, inst);
+        if (commit)
+            commit_begin(commit, pc, inst);
+
+        if (io && stats.insns == next_sample) {
+            sampler_take(sampler, stats.insns, pc, inst, regs, mem);
+            next_sample = sampler->next;
+        }
+        if (io && stats.insns == log_toggle) {
+            log_on = !log_on;
+            log_toggle = (log_on && log_filter->end > 0) ? log_filter->end : -1;
+        }
+        if (log_on && (!log_filter || filter_match(log_filter, pc, opcode))) {
+            if (log_writer)
+                log_writer_put(log_writer, stats.insns, pc, inst);
+            else
+                disasm_cache_write(log_cache, log_file, stats.insns, pc, inst);
         }
 
         switch (opcode) {
@@ -185,6 +696,10 @@ struct Stat simulate(struct memory *mem, int start_addr,
         case 0x03: {
             int32_t imm = (int32_t)inst >> 20;
             uint32_t addr = (uint32_t)(regs[rs1] + imm);
+            if (trace)
+                trace_mem(trace, addr);
+            if (memtrace && (funct3 & 0x3) != 0x3 && funct3 < 0x6)
+                memtrace_access(memtrace, pc, addr, 1 << (funct3 & 0x3), 0);
 
             switch (funct3) {
             case 0x0: { // lb
@@ -264,6 +779,12 @@ struct Stat simulate(struct memory *mem, int start_addr,
             if (imm & 0x800) imm |= 0xFFFFF000;
             uint32_t addr = (uint32_t)(regs[rs1] + imm);
             int32_t v2 = regs[rs2];
+            if (trace)
+                trace_mem(trace, addr);
+            if (commit && funct3 <= 0x2)
+                commit_store(commit, addr, (uint32_t)v2, 1 << funct3);
+            if (memtrace && funct3 <= 0x2)
+                memtrace_access(memtrace, pc, addr, 1 << funct3, 1);
 
             switch (funct3) {
             case 0x0: // sb
@@ -317,40 +838,93 @@ struct Stat simulate(struct memory *mem, int start_addr,
                 if (btfnt_pred != actual_taken)
                     stats.btfnt.mispredictions++;
 
-                // Bimodal + gShare for alle 4 størrelser
-                uint32_t pc_index = pc >> 2;   
-                uint32_t ghr_mask = (1u << ghr_bits) - 1;
-                uint32_t ghr_local = ghr & ghr_mask;
+                uint32_t pc_index = pc >> 2;
 
-                for (int i = 0; i < NUM_PRED_SIZES; i++) {
-                    int size = predictor_sizes[i];
-                    int mask = size - 1;  
+                // Mispredictions til per-branch profilen. Overskrives for hver
+                // størrelse, så til sidst gælder de den sidste i PREDICTOR_SIZES.
+                uint8_t wrong[NUM_PROF_PREDS] = {0};
+                wrong[PROF_BTFNT] = (btfnt_pred != actual_taken);
+
+                // Loop predictor (kun sikre forudsigelser tæller som standalone)
+                int loop_p = 0;
+                int loop_confident = full && opts->loop && loop_predict(&loop_pred, pc, &loop_p);
+                if (loop_confident) {
+                    stats.loop.confident.predictions++;
+                    if (loop_p != actual_taken)
+                        stats.loop.confident.mispredictions++;
+                }
 
-                    // Bimodal
-                    int idx = pc_index & mask;
-                    uint8_t c = bimodal_tables[i][idx];
-                    int pred = counter_predict(c);
+                // Udrullet over PREDICTOR_SIZES med konstant index for hver størrelse
+#define PREDICT_SIZE(idx, size, ghist, phist) \
+                predict_size(&stats, opts, full, idx, (size) - 1, ghist, pc, actual_taken, \
+                             loop_confident, loop_p, wrong);
+                PREDICTOR_SIZES(PREDICT_SIZE)
+#undef PREDICT_SIZE
 
-                    stats.bimodal[i].predictions++;
+                // Lokal historie (PAg / PAp)
+                for (int i = 0; full && i < num_local; i++) {
+                    int pred = local_predict(&local_preds[i], pc);
+                    stats.local[i].pred.predictions++;
                     if (pred != actual_taken)
-                        stats.bimodal[i].mispredictions++;
+                        stats.local[i].pred.mispredictions++;
+                    wrong[PROF_LOCAL] = (pred != actual_taken);
+                    local_update(&local_preds[i], actual_taken);
+                }
 
-                    bimodal_tables[i][idx] = counter_update(c, actual_taken);
+                if (full && opts->loop)
+                    loop_update(&loop_pred, actual_taken, is_backward);
 
-                    // gShare 
-                    int gidx = (int)((pc_index ^ ghr_local) & mask);
-                    c = gshare_tables[i][gidx];
-                    pred = counter_predict(c);
+                // Per-branch profil
+                if (full && opts->profile) {
+                    struct BranchSite *site = profile_site(opts->profile, pc);
+                    if (site)
+                        profile_record(site, actual_taken, wrong);
+                }
 
-                    stats.gshare[i].predictions++;
-                    if (pred != actual_taken)
-                        stats.gshare[i].mispredictions++;
+                // Tællervarianter af bimodal og gShare, udrullet over COUNTER_CONFIGS
+                if (full && opts->counter_variants) {
+#define COUNTER_VARIANT(k, width, init, pol)                                                   \
+                    for (int i = 0; i < NUM_PRED_SIZES; i++) {                                 \
+                        struct CounterVariantStat *cv = &stats.counter_variants[k];            \
+                        uint32_t ghr_local = ghr & ((1u << gshare_hist_bits[i]) - 1);          \
+                        int pred = COUNTER_TABLE_STEP(&counter_bimodal[k][i], ctr##width##_step_##pol, \
+                                                      pc_index, actual_taken);                 \
+                        cv->bimodal[i].predictions++;                                          \
+                        if (pred != actual_taken)                                              \
+                            cv->bimodal[i].mispredictions++;                                   \
+                        pred = COUNTER_TABLE_STEP(&counter_gshare[k][i], ctr##width##_step_##pol, \
+                                                  pc_index ^ ghr_local, actual_taken);         \
+                        cv->gshare[i].predictions++;                                           \
+                        if (pred != actual_taken)                                              \
+                            cv->gshare[i].mispredictions++;                                    \
+                    }
+                    COUNTER_CONFIGS(COUNTER_VARIANT)
+#undef COUNTER_VARIANT
+                }
 
-                    gshare_tables[i][gidx] = counter_update(c, actual_taken);
+                // gShare sweep over alle historielængder
+                if (full && opts->gshare_sweep) {
+                    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+                        uint32_t mask = predictor_sizes[i] - 1;
+                        for (int h = 0; h <= gshare_sweep_max[i]; h++) {
+                            uint32_t sidx = (pc_index ^ (ghr & ((1u << h) - 1))) & mask;
+                            uint8_t c = gshare_sweep_tables[i][h][sidx];
+                            stats.gshare_sweep[i][h].predictions++;
+                            if (counter_predict(c) != actual_taken)
+                                stats.gshare_sweep[i][h].mispredictions++;
+                            gshare_sweep_tables[i][h][sidx] = counter_update(c, actual_taken);
+                        }
+                    }
                 }
 
                 // Opdaterer global history til gShare
-                ghr = ((ghr << 1) | (actual_taken ? 1u : 0u)) & ((1u << ghr_bits) - 1);
+                ghr = ((ghr << 1) | (actual_taken ? 1u : 0u)) & ((1u << MAX_GSHARE_HIST) - 1);
+
+                if (full && !warmup_done && stats.nt.predictions == opts->warmup) {
+                    take_snapshot(&warmup_snapshot, &stats);
+                    indirect_sites_reset(stats.targets.sites);
+                    warmup_done = 1;
+                }
             }
            
 
@@ -379,6 +953,17 @@ struct Stat simulate(struct memory *mem, int start_addr,
             imm |= (inst >> 11) & 0x100000;     // 20
             if (imm & 0x100000) imm |= 0xFFE00000;
 
+            // jal med link register er et call, ellers et direkte hop
+            if (!full || !opts->targets) {
+                stats.targets.kind[is_link_reg(rd) ? JUMP_CALL : JUMP_DIRECT].predictions++;
+            } else if (is_link_reg(rd)) {
+                btb_predict_jump(&stats, JUMP_CALL, pc, pc + imm);
+                ras_push(&ras, pc + 4);
+                tc_path_update(&itc, pc + imm);
+            } else {
+                btb_predict_jump(&stats, JUMP_DIRECT, pc, pc + imm);
+            }
+
             write_reg(regs, rd, pc + 4);
             next_pc = pc + imm;
             break;
@@ -387,6 +972,23 @@ struct Stat simulate(struct memory *mem, int start_addr,
         case 0x67: { // jalr
             int32_t imm = (int32_t)inst >> 20;
             uint32_t target = (uint32_t)(regs[rs1] + imm) & ~1u;
+
+            // jalr x0, 0(ra) er return og forudsiges med RAS. Alle andre jalr
+            // (inkl. indirekte calls) er indirekte hop og bruger BTB + target cache.
+            if (!full || !opts->targets) {
+                stats.targets.kind[rd == 0 && is_link_reg(rs1) ? JUMP_RETURN : JUMP_INDIRECT].predictions++;
+            } else if (rd == 0 && is_link_reg(rs1)) {
+                uint32_t pred;
+                stats.targets.kind[JUMP_RETURN].predictions++;
+                if (!ras_pop(&ras, &pred) || pred != target)
+                    stats.targets.kind[JUMP_RETURN].mispredictions++;
+            } else {
+                predict_indirect(&stats, pc, target);
+                tc_path_update(&itc, target);
+                if (is_link_reg(rd))
+                    ras_push(&ras, pc + 4);
+            }
+
             write_reg(regs, rd, pc + 4);
             next_pc = target;
             break;
@@ -402,10 +1004,15 @@ struct Stat simulate(struct memory *mem, int start_addr,
                     int c = getchar();
                     if (c == EOF) c = -1;
                     write_reg(regs, 10, c);
+                    if (trace)
+                        trace_reg(trace, 10, (uint32_t)c);
+                    if (commit)
+                        commit_reg(commit, 10, (uint32_t)c);
                 } else if (a7 == 2) {   // putchar
                     putchar(a0 & 0xFF);
                     fflush(stdout);
                 } else if (a7 == 3 || a7 == 93) { // exit
+                    finish_predictors(&stats, opts);
                     return stats;
                 }
             }
@@ -414,10 +1021,97 @@ struct Stat simulate(struct memory *mem, int start_addr,
 
         default:
             fprintf(stderr, "Unknown instruction %08x at %08x\n", inst, pc);
+            finish_predictors(&stats, opts);
             return stats;
         }
 
         regs[0] = 0;   // x0 er altid 0
+        if ((trace || commit) && rd && writes_rd(opcode)) {
+            if (trace)
+                trace_reg(trace, rd, (uint32_t)regs[rd]);
+            if (commit)
+                commit_reg(commit, rd, (uint32_t)regs[rd]);
+        }
         pc = next_pc;
+
+        if (io && stats.insns == next_interval)
+            write_interval(&stats, opts);
     }
-}
\ No newline at end of file
+}
+// Slår nogen valgfri predictor eller analyse til? Ellers bruges den
+// specialiserede løkke uden dem.
+static int needs_full_loop(const struct SimOptions *opts) {
+    return opts->gshare_sweep || opts->counter_variants || opts->aliasing ||
+           opts->tage || opts->perceptron || opts->tournament || opts->local ||
+           opts->loop || opts->targets || opts->profile || opts->warmup;
+}
+
+// Skrives der noget undervejs: traces, -l, samples eller snapshots?
+static int needs_io_loop(const struct SimOptions *opts, FILE *log_file) {
+    return log_file || opts->interval || opts->trace || opts->commit ||
+           opts->sampler || opts->memtrace;
+}
+
+struct Stat simulate(struct memory *mem, int start_addr,
+                     FILE *log_file, struct symbols* symbols,
+                     const struct SimOptions *opts)
+{
+    struct Stat stats = {0};
+
+    // init branch predictors for hver simulering
+    init_predictors(opts);
+    stats.gshare_sweep_enabled = opts->gshare_sweep;
+    stats.counter_variants_enabled = opts->counter_variants;
+    stats.aliasing_enabled = opts->aliasing;
+    stats.tage_enabled = opts->tage;
+    stats.perceptron_enabled = opts->perceptron;
+    stats.tournament_enabled = opts->tournament;
+    stats.local_enabled = opts->local;
+    stats.num_local = num_local;
+    stats.loop_enabled = opts->loop;
+    stats.targets_enabled = opts->targets;
+    if (opts->profile)
+        opts->profile->enabled = profile_mask(opts);
+    warmup_done = 0;
+    interval_prev = stats;
+    next_interval = opts->interval > 0 ? opts->interval : -1;
+    if (opts->interval_file)
+        interval_header(opts->interval_file, &stats);
+    for (int k = 0; k < NUM_COUNTER_CONFIGS; k++) {
+        stats.counter_variants[k].width  = counter_configs[k][0];
+        stats.counter_variants[k].init   = counter_configs[k][1];
+        stats.counter_variants[k].policy = counter_configs[k][2];
+    }
+    for (int i = 0; i < NUM_PRED_SIZES; i++)
+        stats.gshare_hist[i] = gshare_hist_bits[i];
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        stats.tage_bits[i] = tage_preds[i].used_bits;
+        if (opts->perceptron) {
+            stats.perceptron_bits[i] = perc_preds[i].used_bits;
+            stats.perceptron_hist[i] = perc_preds[i].hist_len;
+        }
+    }
+    for (int i = 0; i < num_local; i++) {
+        stats.local[i].bht_entries = local_preds[i].bht_entries;
+        stats.local[i].hist_bits   = local_preds[i].hist_bits;
+        stats.local[i].pht_entries = local_preds[i].pht_entries;
+    }
+    stats.loop.entries = loop_entries;
+    if (opts->targets && (stats.targets.sites = indirect_sites_create(INDIRECT_SITES_INIT)) == NULL)
+        predictor_error("Could not set up the indirect jump site table");
+    const struct TargetConfig *tcfg = &opts->target_cfg;
+    stats.targets.btb_sets = tcfg->btb_sets;
+    stats.targets.btb_ways = tcfg->btb_ways;
+    stats.targets.btb_tag_bits = tcfg->btb_tag_bits;
+    stats.targets.ras_depth = tcfg->ras_depth;
+    stats.targets.ras_wrap = tcfg->ras_wrap;
+    stats.targets.itc_entries = tcfg->itc_entries;
+    stats.targets.itc_hist_bits = tcfg->itc_hist_bits;
+
+    uint32_t pc = (uint32_t)start_addr;
+    if (needs_io_loop(opts, log_file))
+        return run(stats, mem, pc, log_file, symbols, opts, 1, 1);
+    if (needs_full_loop(opts))
+        return run(stats, mem, pc, NULL, symbols, opts, 1, 0);
+    return run(stats, mem, pc, NULL, symbols, opts, 0, 0);
+}
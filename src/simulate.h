@@ -1,10 +1,27 @@
 #ifndef __SIMULATE_H__
 #define __SIMULATE_H__
-#define NUM_PRED_SIZES 4
+#define MAX_LOCAL_CONFIGS 8
+#define NUM_COUNTER_CONFIGS 8
 
 #include "memory.h"
 #include "read_elf.h"
+#include "alias.h"
 #include <stdio.h>
+#include <stdint.h>
+
+// Predictor størrelser vælges ved build: make config CONFIG=fil.h
+#ifndef PREDICTOR_CONFIG
+#define PREDICTOR_CONFIG "predictor_config.h"
+#endif
+#include PREDICTOR_CONFIG
+
+// Hjælpemakroer til PREDICTOR_SIZES: antal størrelser og initialiserere
+#define PRED_COUNT_ONE(idx, size, ghist, phist)  + 1
+#define PRED_SIZE_ENTRY(idx, size, ghist, phist) [idx] = size,
+#define PRED_GHIST_ENTRY(idx, size, ghist, phist) [idx] = ghist,
+#define PRED_PHIST_ENTRY(idx, size, ghist, phist) [idx] = phist,
+#define NUM_PRED_SIZES (0 PREDICTOR_SIZES(PRED_COUNT_ONE))
+#define MAX_PRED_SIZE (1 << MAX_GSHARE_HIST)
 
 // Simulerer RISC-V programmet i givet lager og fra given start adresse
 
@@ -13,9 +30,95 @@ struct PredictorStat {
     unsigned long long mispredictions;
 };
 
+// Bimodal og gShare med en anden tællerbredde/starttilstand/politik
+struct CounterVariantStat {
+    struct PredictorStat bimodal[NUM_PRED_SIZES];
+    struct PredictorStat gshare[NUM_PRED_SIZES];
+    int width;
+    int init;
+    int policy;     // enum CounterPolicy
+};
+
+// Tournament (bimodal vs gShare) samt hvor tit hver komponent blev valgt og havde ret
+struct TournamentStat {
+    struct PredictorStat pred;
+    unsigned long long chose_bimodal;
+    unsigned long long bimodal_correct;
+    unsigned long long chose_gshare;
+    unsigned long long gshare_correct;
+};
+
+// Lokal historie predictor og dens konfiguration
+struct LocalStat {
+    struct PredictorStat pred;
+    int bht_entries;
+    int hist_bits;
+    int pht_entries;
+};
+
+// Loop predictor: standalone tæller kun sikre forudsigelser (dækning =
+// confident.predictions / alle branches), override er gShare + loop
+struct LoopStat {
+    struct PredictorStat confident;
+    struct PredictorStat gshare_override[NUM_PRED_SIZES];
+    int entries;
+};
+
+// Typer af ubetingede hop (jal/jalr) til target prediction
+enum JumpKind {
+    JUMP_DIRECT,    // jal uden link
+    JUMP_CALL,      // jal med link (ra/t0)
+    JUMP_RETURN,    // jalr x0, 0(ra)
+    JUMP_INDIRECT,  // øvrige jalr, inkl. indirekte calls
+    NUM_JUMP_KINDS
+};
+
+// Tællere for én indirekte jalr
+struct IndirectSite {
+    uint32_t pc;
+    int used;           // 0 = ledig slot
+    unsigned long long execs;
+    unsigned long long btb_misses;
+    unsigned long long itc_misses;
+};
+
+// Hashtabel på pc (lineær probing) over indirekte jalr sites. Ligger på heapen
+// udenfor Stat, så snapshots ikke kopierer den, og vokser så ingen sites tabes.
+struct IndirectSites {
+    struct IndirectSite *slots;
+    int capacity;       // 2^n
+    int count;
+};
+
+void indirect_sites_delete(struct IndirectSites *sites);
+
+// BTB/RAS target prediction: predictions = hop, mispredictions = forkert/manglende target
+struct TargetStat {
+    struct PredictorStat kind[NUM_JUMP_KINDS];
+    unsigned long long ras_overflows;
+    unsigned long long ras_underflows;
+
+    // Indirekte target cache på JUMP_INDIRECT hop, samt per-site tællere
+    struct PredictorStat itc;
+    struct IndirectSites *sites;    // NULL uden -targets, frigives med indirect_sites_delete
+
+    int btb_sets;
+    int btb_ways;
+    int btb_tag_bits;   // 0 = fuldt tag
+    int ras_depth;
+    int ras_wrap;       // 1 = overskriv ældste ved overflow, 0 = drop
+    int itc_entries;
+    int itc_hist_bits;
+};
+
 struct Stat {
     long int insns;
 
+    // Warmup: tællerne herunder dækker kun tiden efter de første
+    // warmup_branches branches (warmup_insns instruktioner)
+    unsigned long long warmup_branches;
+    long int warmup_insns;
+
     // Always Not Taken
     struct PredictorStat nt;
 
@@ -25,12 +128,109 @@ struct Stat {
     // Bimodal og gShare – én entry per tabelstørrelse
     struct PredictorStat bimodal[NUM_PRED_SIZES];
     struct PredictorStat gshare[NUM_PRED_SIZES];
+    int gshare_hist[NUM_PRED_SIZES];    // historielængde brugt af gShare ovenfor
+
+    // gShare sweep: [størrelse][historielængde], kun udfyldt med -gshare-sweep
+    int gshare_sweep_enabled;
+    struct PredictorStat gshare_sweep[NUM_PRED_SIZES][MAX_GSHARE_HIST + 1];
+
+    // Tællervarianter, kun udfyldt med -counters
+    int counter_variants_enabled;
+    struct CounterVariantStat counter_variants[NUM_COUNTER_CONFIGS];
+
+    // Tournament (-tournament)
+    int tournament_enabled;
+    struct TournamentStat tournament[NUM_PRED_SIZES];
+
+    // Aliasing analyse, kun udfyldt med -aliasing
+    int aliasing_enabled;
+    struct AliasStat alias_bimodal[NUM_PRED_SIZES];
+    struct AliasStat alias_gshare[NUM_PRED_SIZES];
+
+    // TAGE med samme storage budget som gShare af samme størrelse (-tage)
+    int tage_enabled;
+    struct PredictorStat tage[NUM_PRED_SIZES];
+    int tage_bits[NUM_PRED_SIZES];
+
+    // Hashed perceptron, samme storage budget, kun udfyldt med -perceptron
+    int perceptron_enabled;
+    struct PredictorStat perceptron[NUM_PRED_SIZES];
+    int perceptron_bits[NUM_PRED_SIZES];
+    int perceptron_hist[NUM_PRED_SIZES];
+
+    // PAg / PAp (-local), num_local konfigurationer
+    int local_enabled;
+    int num_local;
+    struct LocalStat local[MAX_LOCAL_CONFIGS];
+
+    // Loop predictor (-loop)
+    int loop_enabled;
+    struct LoopStat loop;
+
+    // jal/jalr target prediction. Hop tælles altid (predictions),
+    // BTB/RAS/target cache og misses kun med -targets.
+    int targets_enabled;
+    struct TargetStat targets;
 };
 
 
 // NOTE: Use of symbols provide for nicer disassembly, but is not required for A4.
 // Feel free to remove this parameter or pass in a NULL pointer and ignore it.
 
-struct Stat simulate(struct memory *mem, int start_addr, FILE *log_file, struct symbols* symbols);
+// Valgfrie analyser der slås til fra kommandolinjen
+struct BranchProfile;
+struct TraceWriter;
+struct TraceFilter;
+struct CommitWriter;
+struct Sampler;
+struct MemTraceWriter;
+
+// Geometri for en lokal historie predictor (-local-config)
+struct LocalConfig {
+    int bht_entries;    // 2^n
+    int hist_bits;
+    int pht_entries;    // 2^n og mindst 2^hist_bits
+};
+
+// Geometri for BTB, RAS og indirekte target cache (-btb, -ras, -itc)
+struct TargetConfig {
+    int btb_sets;       // 2^n
+    int btb_ways;
+    int btb_tag_bits;   // 0 = fuldt tag
+    int ras_depth;
+    int ras_wrap;       // 1 = overskriv ældste ved overflow, 0 = drop
+    int itc_entries;    // 2^n
+    int itc_hist_bits;
+};
+
+// Nye valgfrie analyser skal også med i needs_full_loop() eller
+// needs_io_loop() i simulate.c
+struct SimOptions {
+    int gshare_sweep;   // kør gShare med alle historielængder 0..log2(størrelse)
+    int counter_variants;   // kør bimodal/gShare med hver tællervariant
+    int aliasing;       // aliasing analyse af bimodal/gShare tabellerne
+    // predictors ud over NT/BTFNT/bimodal/gShare, alle slået fra som standard
+    int tage;
+    int perceptron;     // hashed perceptron
+    int tournament;
+    int local;          // PAg / PAp
+    struct LocalConfig local_cfg[MAX_LOCAL_CONFIGS];
+    int num_local_cfg;  // 0 = standard sættet af PAg/PAp
+    int loop;           // loop predictor, alene og som override på gShare
+    int targets;        // BTB, RAS og indirekte target cache til jal/jalr
+    struct TargetConfig target_cfg;
+    struct BranchProfile *profile;  // per-branch profil, NULL = slået fra
+    unsigned long long warmup;      // antal branches der ikke tælles med, 0 = ingen
+    long interval;                  // snapshot hver interval instruktioner, 0 = slået fra
+    FILE *interval_file;            // tidsserie med snapshots
+    struct TraceWriter *trace;      // binært trace (-t), NULL = slået fra
+    const struct TraceFilter *log_filter;   // hvad -l logger, NULL = alt
+    struct CommitWriter *commit;    // commit log (-c), NULL = slået fra
+    struct Sampler *sampler;        // samplet tracing, NULL = slået fra
+    struct MemTraceWriter *memtrace;    // load/store adresser (-m), NULL = slået fra
+};
+
+struct Stat simulate(struct memory *mem, int start_addr, FILE *log_file, struct symbols* symbols,
+                     const struct SimOptions *opts);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "snapshot.h"
+
+static void pstat_sub(struct PredictorStat *a, const struct PredictorStat *b) {
+    a->predictions -= b->predictions;
+    a->mispredictions -= b->mispredictions;
+}
+
+static void alias_sub(struct AliasStat *a, const struct AliasStat *b) {
+    a->accesses -= b->accesses;
+    a->aliased -= b->aliased;
+    a->destructive -= b->destructive;
+    a->constructive -= b->constructive;
+    a->unpredictable -= b->unpredictable;
+}
+
+void stat_subtract(struct Stat *s, const struct Stat *base) {
+    pstat_sub(&s->nt, &base->nt);
+    pstat_sub(&s->btfnt, &base->btfnt);
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        pstat_sub(&s->bimodal[i], &base->bimodal[i]);
+        pstat_sub(&s->gshare[i], &base->gshare[i]);
+        for (int h = 0; h <= MAX_GSHARE_HIST; h++)
+            pstat_sub(&s->gshare_sweep[i][h], &base->gshare_sweep[i][h]);
+
+        struct TournamentStat *t = &s->tournament[i];
+        const struct TournamentStat *bt = &base->tournament[i];
+        pstat_sub(&t->pred, &bt->pred);
+        t->chose_bimodal -= bt->chose_bimodal;
+        t->bimodal_correct -= bt->bimodal_correct;
+        t->chose_gshare -= bt->chose_gshare;
+        t->gshare_correct -= bt->gshare_correct;
+
+        alias_sub(&s->alias_bimodal[i], &base->alias_bimodal[i]);
+        alias_sub(&s->alias_gshare[i], &base->alias_gshare[i]);
+        pstat_sub(&s->tage[i], &base->tage[i]);
+        pstat_sub(&s->perceptron[i], &base->perceptron[i]);
+        pstat_sub(&s->loop.gshare_override[i], &base->loop.gshare_override[i]);
+    }
+    for (int k = 0; k < NUM_COUNTER_CONFIGS; k++) {
+        for (int i = 0; i < NUM_PRED_SIZES; i++) {
+            pstat_sub(&s->counter_variants[k].bimodal[i], &base->counter_variants[k].bimodal[i]);
+            pstat_sub(&s->counter_variants[k].gshare[i], &base->counter_variants[k].gshare[i]);
+        }
+    }
+    for (int i = 0; i < s->num_local; i++)
+        pstat_sub(&s->local[i].pred, &base->local[i].pred);
+    pstat_sub(&s->loop.confident, &base->loop.confident);
+
+    struct TargetStat *tg = &s->targets;
+    const struct TargetStat *btg = &base->targets;
+    for (int k = 0; k < NUM_JUMP_KINDS; k++)
+        pstat_sub(&tg->kind[k], &btg->kind[k]);
+    tg->ras_overflows -= btg->ras_overflows;
+    tg->ras_underflows -= btg->ras_underflows;
+    pstat_sub(&tg->itc, &btg->itc);
+    // per-site tællerne ligger udenfor Stat og nulstilles i simulate når warmup slutter
+}
+
+static const int interval_sizes[NUM_PRED_SIZES] = { PREDICTOR_SIZES(PRED_SIZE_ENTRY) };
+
+// Kolonner for predictors der er slået fra udelades
+void interval_header(FILE *out, const struct Stat *s) {
+    fprintf(out, "# insns branches taken NT BTFNT");
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        int n = interval_sizes[i];
+        fprintf(out, " Bimodal%d gShare%d", n, n);
+        if (s->tournament_enabled)
+            fprintf(out, " Tourn%d", n);
+        if (s->tage_enabled)
+            fprintf(out, " TAGE%d", n);
+        if (s->perceptron_enabled)
+            fprintf(out, " Percep%d", n);
+    }
+    for (int i = 0; i < s->num_local; i++)
+        fprintf(out, " Local%d", i);
+    if (s->loop_enabled)
+        fprintf(out, " Loop");
+    if (s->targets_enabled)
+        fprintf(out, " jump_target_misses");
+    fprintf(out, "\n");
+}
+
+void interval_write(FILE *out, const struct Stat *cur, const struct Stat *prev) {
+    struct Stat d = *cur;
+    stat_subtract(&d, prev);
+
+    unsigned long long target_misses = 0;
+    for (int k = 0; k < NUM_JUMP_KINDS; k++)
+        target_misses += d.targets.kind[k].mispredictions;
+
+    // NT fejler netop på de tagne branches
+    fprintf(out, "%ld %llu %llu %llu %llu", cur->insns, d.nt.predictions,
+            d.nt.mispredictions, d.nt.mispredictions, d.btfnt.mispredictions);
+    for (int i = 0; i < NUM_PRED_SIZES; i++) {
+        fprintf(out, " %llu %llu", d.bimodal[i].mispredictions, d.gshare[i].mispredictions);
+        if (cur->tournament_enabled)
+            fprintf(out, " %llu", d.tournament[i].pred.mispredictions);
+        if (cur->tage_enabled)
+            fprintf(out, " %llu", d.tage[i].mispredictions);
+        if (cur->perceptron_enabled)
+            fprintf(out, " %llu", d.perceptron[i].mispredictions);
+    }
+    for (int i = 0; i < cur->num_local; i++)
+        fprintf(out, " %llu", d.local[i].pred.mispredictions);
+    if (cur->loop_enabled)
+        fprintf(out, " %llu", d.loop.confident.mispredictions);
+    if (cur->targets_enabled)
+        fprintf(out, " %llu", target_misses);
+    fprintf(out, "\n");
+}
@@ -0,0 +1,19 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdio.h>
+#include "simulate.h"
+
+// Snapshots af predictor statistikken: warmup fratrækkes ved at tage et
+// snapshot når warmup er slut, og intervaller skrives som forskellen mellem
+// to snapshots.
+
+// Trækker tællerne i base fra s, så s kun dækker tiden efter base blev taget.
+// Konfiguration, insns og aliasing entries røres ikke.
+void stat_subtract(struct Stat *s, const struct Stat *base);
+
+// Tidsserie: én linje per interval med mispredictions for hver predictor der kører
+void interval_header(FILE *out, const struct Stat *s);
+void interval_write(FILE *out, const struct Stat *cur, const struct Stat *prev);
+
+#endif
@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+// Et record fylder højst 1 + 5 + 4 + 6 + 5 bytes
+#define TRACE_MAX_RECORD 21
+
+// Returnerer 1 hvis ordet skal med i tracet, og opdaterer cachen
+static inline int cache_miss(struct TraceCache *c, uint32_t pc, uint32_t inst) {
+    uint32_t slot = (pc >> 2) & ((1u << TRACE_CACHE_BITS) - 1);
+    if (c->valid[slot] && c->pc[slot] == pc && c->inst[slot] == inst)
+        return 0;
+    c->valid[slot] = 1;
+    c->pc[slot] = pc;
+    c->inst[slot] = inst;
+    return 1;
+}
+
+static void trace_flush(struct TraceWriter *tw) {
+    if (tw->pos)
+        fwrite(tw->buf, 1, tw->pos, tw->out);
+    tw->pos = 0;
+}
+
+struct TraceWriter *trace_open(FILE *out) {
+    struct TraceWriter *tw = calloc(1, sizeof *tw);
+    if (!tw)
+        return NULL;
+    tw->out = out;
+    tw->prev_pc = 0;
+    memcpy(tw->buf, TRACE_MAGIC, 4);
+    tw->pos = 4;
+    return tw;
+}
+
+void trace_emit(struct TraceWriter *tw) {
+    if (tw->pos + TRACE_MAX_RECORD > TRACE_BUF_SIZE)
+        trace_flush(tw);
+    const struct TraceInsn *r = &tw->cur;
+    uint8_t *start = tw->buf + tw->pos;
+    uint8_t *p = start + 1;
+    uint8_t flags = 0;
+
+    if (r->pc == tw->prev_pc + 4)
+        flags |= TRACE_PC_SEQ;
+    else
+        p = put_varint(p, zigzag((int32_t)(r->pc - (tw->prev_pc + 4))));
+    tw->prev_pc = r->pc;
+
+    if (cache_miss(&tw->cache, r->pc, r->inst)) {
+        flags |= TRACE_INST;
+        p = put_u32(p, r->inst);
+    }
+    if (r->rd) {
+        flags |= TRACE_REG;
+        *p++ = (uint8_t)r->rd;
+        p = put_varint(p, zigzag((int32_t)(r->value - tw->regs[r->rd & 31])));
+        tw->regs[r->rd & 31] = r->value;
+    }
+    if (r->has_mem) {
+        flags |= TRACE_MEM;
+        p = put_varint(p, zigzag((int32_t)(r->mem_addr - tw->prev_mem)));
+        tw->prev_mem = r->mem_addr;
+    }
+    *start = flags;
+    tw->pos = p - tw->buf;
+    tw->records++;
+    tw->pending = 0;
+}
+
+void trace_close(struct TraceWriter *tw) {
+    if (!tw)
+        return;
+    if (tw->pending)
+        trace_emit(tw);
+    trace_flush(tw);
+    fclose(tw->out);
+    free(tw);
+}
+
+struct TraceReader *trace_reader_open(FILE *in) {
+    char magic[4];
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, TRACE_MAGIC, 4) != 0)
+        return NULL;
+    struct TraceReader *tr = calloc(1, sizeof *tr);
+    if (tr)
+        byte_reader_init(&tr->rd, in, tr->buf, TRACE_BUF_SIZE);
+    return tr;
+}
+
+void trace_reader_close(struct TraceReader *tr) {
+    free(tr);
+}
+
+static int read_u32(struct ByteReader *br, uint32_t *v) {
+    uint32_t result = 0;
+    for (int i = 0; i < 4; i++) {
+        int b = get_byte(br);
+        if (b < 0)
+            return -1;
+        result |= (uint32_t)b << (8 * i);
+    }
+    *v = result;
+    return 0;
+}
+
+int trace_read(struct TraceReader *tr, struct TraceInsn *rec) {
+    int flags = get_byte(&tr->rd);
+    if (flags < 0)
+        return 0;
+    uint32_t v;
+
+    rec->pc = tr->prev_pc + 4;
+    if (!(flags & TRACE_PC_SEQ)) {
+        if (get_varint(&tr->rd, &v))
+            return -1;
+        rec->pc += (uint32_t)unzigzag(v);
+    }
+    tr->prev_pc = rec->pc;
+
+    uint32_t slot = (rec->pc >> 2) & ((1u << TRACE_CACHE_BITS) - 1);
+    if (flags & TRACE_INST) {
+        if (read_u32(&tr->rd, &rec->inst))
+            return -1;
+        cache_miss(&tr->cache, rec->pc, rec->inst);
+    } else {
+        if (!tr->cache.valid[slot] || tr->cache.pc[slot] != rec->pc)
+            return -1;
+        rec->inst = tr->cache.inst[slot];
+    }
+
+    rec->rd = 0;
+    if (flags & TRACE_REG) {
+        int rd = get_byte(&tr->rd);
+        if (rd < 0 || rd > 31 || get_varint(&tr->rd, &v))
+            return -1;
+        rec->rd = (uint32_t)rd;
+        rec->value = tr->regs[rd] + (uint32_t)unzigzag(v);
+        tr->regs[rd] = rec->value;
+    }
+
+    rec->has_mem = 0;
+    if (flags & TRACE_MEM) {
+        if (get_varint(&tr->rd, &v))
+            return -1;
+        rec->has_mem = 1;
+        rec->mem_addr = tr->prev_mem + (uint32_t)unzigzag(v);
+        tr->prev_mem = rec->mem_addr;
+    }
+    return 1;
+}
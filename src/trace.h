@@ -0,0 +1,107 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include "binio.h"
+
+// Binært instruktionstrace (-t) som alternativ til tekstloggen fra -l.
+// Hver instruktion er ét record:
+//   flag byte (TRACE_*)
+//   [pc delta]       zigzag varint af pc - (forrige pc + 4), hvis ikke TRACE_PC_SEQ
+//   [instruktion]    4 bytes, hvis TRACE_INST
+//   [writeback]      rd byte + zigzag varint af værdi - rd's forrige værdi, hvis TRACE_REG
+//   [adresse]        zigzag varint af adresse - forrige adresse, hvis TRACE_MEM
+// Instruktionsordet skrives kun når pc'en ikke står i en direkte mappet cache
+// med samme ord. Læseren holder en identisk cache, så ord der ændres (kode der
+// skrives) bliver skrevet igen. Deltaerne gør at gentagne loop iterationer
+// giver ens bytes, som -z komprimerer godt. Multi-byte værdier er little endian.
+
+// Formatet versioneres med magic. RVT1 skrev writeback værdien som 4 rå bytes,
+// RVT2 skriver delta mod registerets forrige værdi (se ovenfor). RVT1 traces
+// kan ikke læses længere og må optages igen med sim -t.
+#define TRACE_MAGIC "RVT2"
+
+enum {
+    TRACE_PC_SEQ = 1,   // pc = forrige pc + 4
+    TRACE_INST   = 2,
+    TRACE_REG    = 4,
+    TRACE_MEM    = 8,
+};
+
+#define TRACE_CACHE_BITS 16
+#define TRACE_BUF_SIZE (1 << 16)
+
+struct TraceInsn {
+    uint32_t pc;
+    uint32_t inst;
+    uint32_t rd;        // 0 = ingen writeback
+    uint32_t value;
+    int has_mem;
+    uint32_t mem_addr;
+};
+
+struct TraceCache {
+    uint32_t pc[1 << TRACE_CACHE_BITS];
+    uint32_t inst[1 << TRACE_CACHE_BITS];
+    uint8_t valid[1 << TRACE_CACHE_BITS];
+};
+
+struct TraceWriter {
+    FILE *out;
+    struct TraceInsn cur;       // record under opbygning
+    int pending;
+    uint32_t prev_pc;
+    uint32_t prev_mem;
+    uint32_t regs[32];          // seneste skrevne værdi per register
+    unsigned long long records;
+    size_t pos;
+    uint8_t buf[TRACE_BUF_SIZE];
+    struct TraceCache cache;
+};
+
+struct TraceReader {
+    struct ByteReader rd;
+    uint32_t prev_pc;
+    uint32_t prev_mem;
+    uint32_t regs[32];
+    uint8_t buf[TRACE_BUF_SIZE];
+    struct TraceCache cache;
+};
+
+// NULL ved fejl. Filen lukkes af trace_close.
+struct TraceWriter *trace_open(FILE *out);
+// Skriver sidste record, tømmer bufferen og lukker filen
+void trace_close(struct TraceWriter *tw);
+
+// Koder det igangværende record ind i bufferen
+void trace_emit(struct TraceWriter *tw);
+
+// Starter et nyt record; det forrige skrives nu hvor det er komplet
+static inline void trace_begin(struct TraceWriter *tw, uint32_t pc, uint32_t inst) {
+    if (tw->pending)
+        trace_emit(tw);
+    tw->pending = 1;
+    tw->cur.pc = pc;
+    tw->cur.inst = inst;
+    tw->cur.rd = 0;
+    tw->cur.has_mem = 0;
+}
+
+static inline void trace_reg(struct TraceWriter *tw, uint32_t rd, uint32_t value) {
+    tw->cur.rd = rd;
+    tw->cur.value = value;
+}
+
+static inline void trace_mem(struct TraceWriter *tw, uint32_t addr) {
+    tw->cur.has_mem = 1;
+    tw->cur.mem_addr = addr;
+}
+
+// NULL hvis filen ikke er et trace
+struct TraceReader *trace_reader_open(FILE *in);
+void trace_reader_close(struct TraceReader *tr);
+// 1 ved et record, 0 ved slut, -1 ved fejl i filen
+int trace_read(struct TraceReader *tr, struct TraceInsn *rec);
+
+#endif
@@ -0,0 +1,51 @@
+#include <string.h>
+#include "tracefilter.h"
+#include "read_elf.h"
+
+int filter_add_range(struct TraceFilter *f, uint32_t lo, uint32_t hi) {
+    if (f->num_ranges == MAX_FILTER_RANGES)
+        return -1;
+    f->ranges[f->num_ranges].lo = lo;
+    f->ranges[f->num_ranges].hi = hi;
+    f->num_ranges++;
+    return 0;
+}
+
+int filter_add_function(struct TraceFilter *f, struct symbols *symbols, const char *name) {
+    unsigned int start, end;
+    if (symbols_func_range(symbols, name, &start, &end) != 0)
+        return -1;
+    return filter_add_range(f, start, end);
+}
+
+static const struct {
+    const char *name;
+    unsigned mask;
+} class_names[] = {
+    {"alu", CLASS_ALU},
+    {"load", CLASS_LOAD},
+    {"store", CLASS_STORE},
+    {"mem", CLASS_LOAD | CLASS_STORE},
+    {"branch", CLASS_BRANCH},
+    {"jump", CLASS_JUMP},
+    {"system", CLASS_SYSTEM},
+};
+
+int filter_set_classes(struct TraceFilter *f, const char *list) {
+    unsigned mask = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        unsigned found = 0;
+        for (size_t i = 0; i < sizeof class_names / sizeof class_names[0]; i++)
+            if (strlen(class_names[i].name) == len && !strncmp(class_names[i].name, list, len))
+                found = class_names[i].mask;
+        if (!found)
+            return -1;
+        mask |= found;
+        list += len;
+        if (*list == ',')
+            list++;
+    }
+    f->classes = mask;
+    return 0;
+}
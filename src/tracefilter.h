@@ -0,0 +1,67 @@
+#ifndef __TRACEFILTER_H__
+#define __TRACEFILTER_H__
+
+#include <stdint.h>
+
+// Filtre for -l: et vindue af instruktionsnumre, pc intervaller (evt. fra
+// funktionsnavne) og instruktionsklasser. Udenfor vinduet skrives der ikke
+// til loggen, men predictors, profil og traces kører stadig, så statistikken
+// dækker hele kørslen. En nulstillet TraceFilter logger alt.
+
+#define MAX_FILTER_RANGES 16
+
+enum InsnClass {
+    CLASS_ALU    = 1,
+    CLASS_LOAD   = 2,
+    CLASS_STORE  = 4,
+    CLASS_BRANCH = 8,   // betingede branches
+    CLASS_JUMP   = 16,  // jal/jalr
+    CLASS_SYSTEM = 32,
+};
+
+struct PcRange {
+    uint32_t lo;
+    uint32_t hi;        // eksklusiv
+};
+
+struct TraceFilter {
+    long start;         // første instruktion der logges (1 = fra start)
+    long end;           // første instruktion der ikke logges, 0 = ingen slut
+    int num_ranges;     // 0 = alle pc'er
+    struct PcRange ranges[MAX_FILTER_RANGES];
+    unsigned classes;   // maske af InsnClass, 0 = alle
+};
+
+struct symbols;
+
+// returnerer 0 ved succes, -1 hvis der ikke er plads
+int filter_add_range(struct TraceFilter *f, uint32_t lo, uint32_t hi);
+// returnerer 0 ved succes, -1 hvis funktionen ikke findes
+int filter_add_function(struct TraceFilter *f, struct symbols *symbols, const char *name);
+// Komma-separeret liste: alu,load,store,mem,branch,jump,system.
+// Returnerer 0 ved succes, -1 ved ukendt klasse.
+int filter_set_classes(struct TraceFilter *f, const char *list);
+
+static inline unsigned insn_class(uint32_t opcode) {
+    switch (opcode) {
+    case 0x03: return CLASS_LOAD;
+    case 0x23: return CLASS_STORE;
+    case 0x63: return CLASS_BRANCH;
+    case 0x6F: case 0x67: return CLASS_JUMP;
+    case 0x73: return CLASS_SYSTEM;
+    default:   return CLASS_ALU;
+    }
+}
+
+static inline int filter_match(const struct TraceFilter *f, uint32_t pc, uint32_t opcode) {
+    if (f->classes && !(f->classes & insn_class(opcode)))
+        return 0;
+    if (!f->num_ranges)
+        return 1;
+    for (int i = 0; i < f->num_ranges; i++)
+        if (pc >= f->ranges[i].lo && pc < f->ranges[i].hi)
+            return 1;
+    return 0;
+}
+
+#endif